@@ -0,0 +1,443 @@
+// Microbenchmarks for the strategies, trading engine, market data feed and
+// backtester. Builds as its own executable next to the trading system:
+//
+//   g++ -std=c++17 -O2 -pthread bench.cpp -o hftbench
+//
+// Every benchmark reports the median, minimum and mean cost per operation
+// over repeated samples. --json prints the results as JSON for regression
+// tracking; --json=FILE writes them to FILE and keeps the console table.
+//   --min-time=S     seconds to spend sampling each benchmark (default 0.5)
+//   --filter=TEXT    only runs benchmarks whose name contains TEXT
+#define HFT_NO_MAIN
+#include "main.cpp"
+#include <filesystem>
+
+// Results are folded into this so the optimizer cannot drop the measured work
+volatile double benchSink = 0.0;
+
+struct BenchResult {
+    std::string name;
+    std::string unit;       // what one operation is
+    uint64_t samples;
+    uint64_t operations;    // summed over all samples
+    double medianNanos;     // per operation
+    double minNanos;
+    double meanNanos;
+};
+
+const double DEFAULT_BENCH_SECONDS = 0.5;
+const uint64_t MIN_BENCH_SAMPLES = 5;
+
+class BenchRunner {
+private:
+    double minSeconds;
+    std::string filter;
+    std::vector<BenchResult> results;
+
+public:
+    BenchRunner(double seconds, const std::string& nameFilter) : minSeconds(seconds), filter(nameFilter) {}
+
+    bool selected(const std::string& name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // A sample runs opsPerSample operations and returns the nanoseconds spent
+    // on them, excluding any setup it does first. A sample that reports no
+    // time has failed, and the benchmark is dropped.
+    template <typename Sample>
+    void run(const std::string& name, const std::string& unit, uint64_t opsPerSample, Sample&& sample) {
+        if (!selected(name)) return;
+
+        sample();  // warm caches and branch predictors; not recorded
+        std::vector<double> perOp;
+        int64_t spent = 0;
+        int64_t budget = static_cast<int64_t>(minSeconds * 1e9);
+        while (perOp.size() < MIN_BENCH_SAMPLES || spent < budget) {
+            int64_t nanos = sample();
+            if (nanos <= 0) {
+                std::cout << std::left << std::setw(36) << name << "  skipped: sample reported no time\n"
+                    << std::right << std::flush;
+                return;
+            }
+            spent += nanos;
+            perOp.push_back(static_cast<double>(nanos) / opsPerSample);
+        }
+
+        BenchResult result;
+        result.name = name;
+        result.unit = unit;
+        result.samples = perOp.size();
+        result.operations = perOp.size() * opsPerSample;
+        result.meanNanos = std::accumulate(perOp.begin(), perOp.end(), 0.0) / perOp.size();
+        std::sort(perOp.begin(), perOp.end());
+        result.medianNanos = perOp[perOp.size() / 2];
+        result.minNanos = perOp.front();
+        results.push_back(result);
+
+        std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(12) << result.medianNanos << std::setw(12) << result.minNanos
+            << std::setprecision(0) << std::setw(16) << 1e9 / result.medianNanos << "  " << unit << "/s\n"
+            << std::flush;
+    }
+
+    const std::vector<BenchResult>& getResults() const { return results; }
+};
+
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+std::string compilerName() {
+#if defined(__clang__)
+    return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+void writeJson(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "{\n";
+    out << "  \"schema\": 1,\n";
+    out << "  \"compiler\": \"" << jsonEscape(compilerName()) << "\",\n";
+    out << "  \"kernel_isa\": \"" << kernelIsaName(detectKernelIsa()) << "\",\n";
+    out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"unit\": \"" << jsonEscape(r.unit)
+            << "\", \"samples\": " << r.samples << ", \"operations\": " << r.operations
+            << std::fixed << std::setprecision(2)
+            << ", \"ns_per_op_median\": " << r.medianNanos
+            << ", \"ns_per_op_min\": " << r.minNanos
+            << ", \"ns_per_op_mean\": " << r.meanNanos
+            << ", \"ops_per_sec\": " << std::setprecision(0) << 1e9 / r.medianNanos << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+const uint32_t BENCH_SEED = 7;
+
+// Publishes the seeded simulator into provider until every history window is full
+void warmProvider(MarketDataProvider& provider) {
+    GbmSimulator& simulator = provider.getSimulator();
+    int64_t clock = BACKTEST_EPOCH_NANOS;
+    for (size_t step = 0; step < provider.getHistoryWindow(); step++) {
+        simulator.step(clock, [&provider](const MarketData& data) { provider.publish(data); });
+        clock += TICK_INTERVAL_NANOS;
+    }
+}
+
+template <typename Strategy>
+void benchStrategy(BenchRunner& bench, const SymbolTable& symbols, MarketDataProvider& provider) {
+    Strategy strategy;
+    const uint64_t rounds = 100;
+    bench.run("strategy/" + strategy.getName(), "analyze", rounds * symbols.size(), [&]() {
+        double acc = 0.0;
+        int64_t start = monotonicNanos();
+        for (uint64_t r = 0; r < rounds; r++) {
+            for (SymbolId id = 0; id < symbols.size(); id++) {
+                Signal signal = strategy.analyze(id, provider.getHistory(id), provider.getData(id),
+                    provider.getIndicators(id));
+                acc += signal.action + signal.confidence;
+            }
+        }
+        int64_t nanos = monotonicNanos() - start;
+        benchSink = benchSink + acc;
+        return nanos;
+    });
+}
+
+void benchStrategies(BenchRunner& bench, const SymbolTable& symbols) {
+    MarketDataProvider provider(symbols, BENCH_SEED);
+    warmProvider(provider);
+    benchStrategy<ImprovedMeanReversionStrategy>(bench, symbols, provider);
+    benchStrategy<TrendFollowingStrategy>(bench, symbols, provider);
+    benchStrategy<BreakoutStrategy>(bench, symbols, provider);
+}
+
+void benchEngine(BenchRunner& bench, const SymbolTable& symbols) {
+    // A fresh engine per sample keeps the trade journal from growing without bound
+    const uint64_t roundTrips = 50000;
+    bench.run("engine/buy_sell_round_trip", "round trip", roundTrips, [&]() {
+        TradingEngine engine(symbols, 1e12);
+        int64_t start = monotonicNanos();
+        for (uint64_t i = 0; i < roundTrips; i++) {
+            SymbolId id = static_cast<SymbolId>(i % symbols.size());
+            double price = 100.0 + (i & 63);
+            engine.executeBuy(id, price, 10, 0, static_cast<int64_t>(i), price * 0.98, price * 1.02);
+            engine.executeSell(id, price * 1.001, 10, 0, static_cast<int64_t>(i));
+        }
+        int64_t nanos = monotonicNanos() - start;
+        benchSink = benchSink + engine.getCash();
+        return nanos;
+    });
+
+    // The same fills appended to a write-ahead journal in the temp directory.
+    // Each sample checkpoints before timing, so the ring has room for every
+    // record and no snapshot is written while timing.
+    if (bench.selected("engine/journaled_round_trip")) {
+        std::error_code ec;
+        std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+        if (ec) dir = ".";
+        const std::string journalPath = (dir / ("hftbench-" + std::to_string(wallClockNanos()) + ".wal")).string();
+        {
+            WriteAheadJournal journal;
+            std::string error;
+            if (!journal.open(journalPath, symbols, roundTrips * 2 + 16, error)) {
+                std::cout << std::left << std::setw(36) << "engine/journaled_round_trip" << "  skipped: "
+                    << error << "\n" << std::right << std::flush;
+            }
+            else {
+                journal.begin(1e12);
+                bench.run("engine/journaled_round_trip", "round trip", roundTrips, [&]() {
+                    TradingEngine engine(symbols, 1e12);
+                    engine.setJournal(&journal);
+                    if (!engine.checkpoint()) return int64_t(0);
+                    int64_t start = monotonicNanos();
+                    for (uint64_t i = 0; i < roundTrips; i++) {
+                        SymbolId id = static_cast<SymbolId>(i % symbols.size());
+                        double price = 100.0 + (i & 63);
+                        engine.executeBuy(id, price, 10, 0, static_cast<int64_t>(i), price * 0.98, price * 1.02);
+                        engine.executeSell(id, price * 1.001, 10, 0, static_cast<int64_t>(i));
+                    }
+                    int64_t nanos = monotonicNanos() - start;
+                    benchSink = benchSink + engine.getCash();
+                    return nanos;
+                });
+            }
+        }
+        std::remove(journalPath.c_str());
+        std::remove((journalPath + ".snap").c_str());
+    }
+
+    bench.run("engine/mark", "mark", roundTrips, [&]() {
+        TradingEngine engine(symbols, 1e12);
+        for (SymbolId id = 0; id < symbols.size(); id++) engine.executeBuy(id, 100.0, 10, 0, 0, 0.0, 0.0);
+        int64_t start = monotonicNanos();
+        for (uint64_t i = 0; i < roundTrips; i++) {
+            engine.mark(static_cast<SymbolId>(i % symbols.size()), 100.0 + (i & 63));
+        }
+        int64_t nanos = monotonicNanos() - start;
+        benchSink = benchSink + engine.getPortfolioValue();
+        return nanos;
+    });
+}
+
+// Readers on the calling thread while writers (the feed) publish flat out
+template <typename Read>
+void benchFeedRead(BenchRunner& bench, const std::string& name, const SymbolTable& symbols,
+    MarketDataProvider& provider, bool withWriter, Read read) {
+    if (!bench.selected(name)) return;
+
+    std::atomic<bool> writing(withWriter);
+    std::thread writer;
+    if (withWriter) {
+        writer = std::thread([&]() {
+            GbmSimulator& simulator = provider.getSimulator();
+            int64_t clock = BACKTEST_EPOCH_NANOS;
+            while (writing.load(std::memory_order_relaxed)) {
+                simulator.step(clock, [&provider](const MarketData& data) { provider.publish(data); });
+                clock += TICK_INTERVAL_NANOS;
+            }
+        });
+    }
+
+    const uint64_t reads = 200000;
+    bench.run(name, "read", reads, [&]() {
+        double acc = 0.0;
+        int64_t start = monotonicNanos();
+        for (uint64_t i = 0; i < reads; i++) acc += read(static_cast<SymbolId>(i % symbols.size()));
+        int64_t nanos = monotonicNanos() - start;
+        benchSink = benchSink + acc;
+        return nanos;
+    });
+
+    writing.store(false, std::memory_order_relaxed);
+    if (writer.joinable()) writer.join();
+}
+
+void benchFeed(BenchRunner& bench, const SymbolTable& symbols) {
+    MarketDataProvider provider(symbols, BENCH_SEED);
+    warmProvider(provider);
+
+    auto getData = [&provider](SymbolId id) { return provider.getData(id).mid(); };
+    auto getHistory = [&provider](SymbolId id) {
+        PriceWindow window = provider.getHistory(id);
+        return window.size() > 0 ? window[window.size() - 1] : 0.0;
+    };
+    benchFeedRead(bench, "feed/getData", symbols, provider, false, getData);
+    benchFeedRead(bench, "feed/getData_vs_writer", symbols, provider, true, getData);
+    benchFeedRead(bench, "feed/getHistory", symbols, provider, false, getHistory);
+    benchFeedRead(bench, "feed/getHistory_vs_writer", symbols, provider, true, getHistory);
+
+    GbmSimulator& simulator = provider.getSimulator();
+    const uint64_t steps = 1000;
+    bench.run("feed/publish", "tick", steps * symbols.size(), [&]() {
+        int64_t clock = BACKTEST_EPOCH_NANOS;
+        int64_t start = monotonicNanos();
+        for (uint64_t s = 0; s < steps; s++) {
+            simulator.step(clock, [&provider](const MarketData& data) { provider.publish(data); });
+            clock += TICK_INTERVAL_NANOS;
+        }
+        return monotonicNanos() - start;
+    });
+
+    GbmSimulator fast(symbols.size(), BENCH_SEED, FeedGenerator::Fast);
+    bench.run("feed/generate_fast", "tick", steps * symbols.size(), [&]() {
+        double acc = 0.0;
+        int64_t start = monotonicNanos();
+        for (uint64_t s = 0; s < steps; s++) {
+            fast.step(0, [&acc](const MarketData& data) { acc += data.last; });
+        }
+        int64_t nanos = monotonicNanos() - start;
+        benchSink = benchSink + acc;
+        return nanos;
+    });
+}
+
+void benchBook(BenchRunner& bench, const SymbolTable& symbols) {
+    MarketDataProvider provider(symbols, BENCH_SEED);
+    provider.enableBooks(DEFAULT_BOOK_LEVELS);
+    warmProvider(provider);
+    BookStore& books = *provider.getBooks();
+
+    std::vector<MarketData> quotes;
+    provider.getSimulator().step(BACKTEST_EPOCH_NANOS, [&quotes](const MarketData& data) { quotes.push_back(data); });
+    const uint64_t updates = 100000;
+    bench.run("book/synthesize", "update", updates, [&]() {
+        int64_t start = monotonicNanos();
+        for (uint64_t i = 0; i < updates; i++) {
+            MarketData data = quotes[i % quotes.size()];
+            data.bid += (i & 7) * BOOK_TICK_SIZE;
+            data.ask += (i & 7) * BOOK_TICK_SIZE;
+            books.synthesize(data, DEFAULT_BOOK_LEVELS);
+        }
+        return monotonicNanos() - start;
+    });
+
+    bench.run("book/read_sweep", "sweep", updates, [&]() {
+        double acc = 0.0;
+        int64_t start = monotonicNanos();
+        for (uint64_t i = 0; i < updates; i++) {
+            BookDepth depth;
+            books.read(static_cast<SymbolId>(i % symbols.size()), depth);
+            double avg;
+            size_t used;
+            depth.sweep(BOOK_ASK, 500, avg, used);
+            acc += avg;
+        }
+        int64_t nanos = monotonicNanos() - start;
+        benchSink = benchSink + acc;
+        return nanos;
+    });
+
+    // Add, partially fill and delete one order per level, cycling over the universe
+    BookStore l3(symbols.size());
+    uint64_t nextId = 1;
+    bench.run("book/l3_add_reduce_delete", "order", updates, [&]() {
+        int64_t start = monotonicNanos();
+        for (uint64_t i = 0; i < updates; i++) {
+            SymbolId id = static_cast<SymbolId>(i % symbols.size());
+            uint64_t order = nextId++;
+            l3.addOrder(order, id, (i & 1) ? BOOK_ASK : BOOK_BID, 100.0 + (i & 1) * 0.05 + (i & 15) * BOOK_TICK_SIZE, 100);
+            l3.reduceOrder(order, 40);
+            l3.deleteOrder(order);
+        }
+        return monotonicNanos() - start;
+    });
+}
+
+void benchBacktest(BenchRunner& bench, const SymbolTable& symbols, bool batch) {
+    SystemConfig config;
+    config.capital = DEFAULT_BACKTEST_CAPITAL;
+    config.backtestSteps = 2000;
+    config.batchSignals = batch;
+    bench.run(batch ? "backtest/batch_ticks" : "backtest/ticks", "tick",
+        config.backtestSteps * symbols.size(), [&]() {
+            Backtester backtester(symbols, config, nullptr);
+            BacktestResult result = backtester.run();
+            benchSink = benchSink + result.finalValue;
+            return static_cast<int64_t>(result.seconds * 1e9);
+        });
+}
+
+// The same run through the matching venue, with jittered latency and passive entries
+void benchMatchingBacktest(BenchRunner& bench, const SymbolTable& symbols) {
+    SystemConfig config;
+    config.capital = DEFAULT_BACKTEST_CAPITAL;
+    config.backtestSteps = 2000;
+    config.gateway.model = GatewayModel::Matching;
+    config.gateway.latencyNanos = 500000;
+    config.gateway.jitterNanos = 50000;
+    config.tuning.trade.passiveEntries = true;
+    bench.run("backtest/match_ticks", "tick", config.backtestSteps * symbols.size(), [&]() {
+        Backtester backtester(symbols, config, nullptr);
+        BacktestResult result = backtester.run();
+        benchSink = benchSink + result.finalValue;
+        return static_cast<int64_t>(result.seconds * 1e9);
+    });
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = DEFAULT_BENCH_SECONDS;
+    std::string filter;
+    std::string jsonFile;
+    bool jsonToConsole = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 11, "--min-time=") == 0) {
+            seconds = std::atof(arg.substr(11).c_str());
+        }
+        if (arg.compare(0, 9, "--filter=") == 0) {
+            filter = arg.substr(9);
+        }
+        if (arg == "--json") {
+            jsonToConsole = true;
+        }
+        if (arg.compare(0, 7, "--json=") == 0) {
+            jsonFile = arg.substr(7);
+        }
+    }
+
+    // With --json the table goes to stderr so stdout is only the JSON document
+    std::streambuf* console = std::cout.rdbuf();
+    if (jsonToConsole) std::cout.rdbuf(std::cerr.rdbuf());
+
+    calibrateCycleCounter();
+    SymbolTable symbols(ALL_STOCKS);
+    BenchRunner bench(seconds, filter);
+
+    std::cout << std::left << std::setw(36) << "Benchmark" << std::right << std::setw(12) << "Median ns"
+        << std::setw(12) << "Min ns" << std::setw(16) << "Ops/sec" << "\n";
+    benchStrategies(bench, symbols);
+    benchEngine(bench, symbols);
+    benchFeed(bench, symbols);
+    benchBook(bench, symbols);
+    benchBacktest(bench, symbols, false);
+    benchBacktest(bench, symbols, true);
+    benchMatchingBacktest(bench, symbols);
+
+    std::cout.rdbuf(console);
+    if (jsonToConsole) writeJson(std::cout, bench.getResults());
+    if (!jsonFile.empty()) {
+        std::ofstream out(jsonFile);
+        if (!out) {
+            std::cerr << "Cannot write " << jsonFile << "\n";
+            return 1;
+        }
+        writeJson(out, bench.getResults());
+    }
+    return 0;
+}
@@ -1,12 +1,14 @@
 ﻿// Ultra-Efficient HFT System - Fixed P&L & Improved Algorithms
 // Compile: g++ -std=c++17 -O3 -pthread main.cpp -o hft_system
+// Allocation check: add -DHFT_COUNT_ALLOCS and run with --backtest
+// Stage profile: add -DHFT_PROFILE (-DHFT_PROFILE_ITT for VTune tasks, link ittnotify)
 
 #include <iostream>
 #include <vector>
 #include <string>
-#include <map>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <chrono>
 #include <cmath>
@@ -17,8 +19,123 @@
 #include <random>
 #include <sstream>
 #include <ctime>
-#include <deque>
+#include <cstdlib>
+#include <fstream>
 #include <limits>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <type_traits>
+#include <new>
+#include <csignal>
+#include <cassert>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#include <io.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+
+#if defined(HFT_PROFILE_ITT) && !defined(HFT_PROFILE)
+#define HFT_PROFILE 1
+#endif
+#ifdef HFT_PROFILE_ITT
+#include <ittnotify.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HFT_HAS_RDTSC 1
+#define HFT_HAS_AVX2_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// MSVC accepts AVX2 intrinsics anywhere; GCC and Clang need the function tagged
+#if defined(HFT_HAS_AVX2_KERNELS) && !defined(_MSC_VER)
+#define HFT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HFT_TARGET_AVX2
+#endif
+
+#ifdef HFT_COUNT_ALLOCS
+// Build with -DHFT_COUNT_ALLOCS to count every global heap allocation; the
+// backtester uses it to check that steady-state trading never allocates
+std::atomic<uint64_t> heapAllocations(0);
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size != 0 ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+// Over-aligned types (alignas above the default) come through here
+void* operator new(size_t size, std::align_val_t align) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = static_cast<size_t>(align);
+    size_t bytes = (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment;
+#ifdef _MSC_VER
+    if (void* p = _aligned_malloc(bytes, alignment)) return p;
+#else
+    if (void* p = std::aligned_alloc(alignment, bytes)) return p;
+#endif
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+#ifdef _MSC_VER
+inline void freeAligned(void* p) noexcept { _aligned_free(p); }
+#else
+inline void freeAligned(void* p) noexcept { std::free(p); }
+#endif
+
+// GCC cannot pair the inlined operator new above with these frees and flags every delete
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { freeAligned(p); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+#endif
 
 namespace Color {
     const std::string RESET = "\033[0m";
@@ -44,764 +161,8341 @@ const std::vector<std::string> ALL_STOCKS = {
     "SCHW", "FI", "PGR", "BDX", "BSX", "CL", "EOG", "HUM", "ETN", "SLB"
 };
 
-std::string getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time), "%H:%M:%S");
-    return ss.str();
-}
+using SymbolId = uint32_t;
+const SymbolId INVALID_SYMBOL = std::numeric_limits<SymbolId>::max();
+using StrategyId = uint16_t;
 
-struct MarketData {
-    std::string symbol;
-    double bid;
-    double ask;
-    double last;
-    int64_t volume;
-    int64_t timestamp;
+// Interns symbol names once at startup so the hot path only deals in dense IDs
+class SymbolTable {
+private:
+    std::vector<std::string> names;
+    std::unordered_map<std::string, SymbolId> ids;
 
-    double spread() const { return ask - bid; }
-    double mid() const { return (bid + ask) / 2.0; }
-};
+public:
+    explicit SymbolTable(const std::vector<std::string>& symbols) {
+        names.reserve(symbols.size());
+        for (size_t i = 0; i < symbols.size(); i++) {
+            intern(symbols[i]);
+        }
+    }
 
-struct Trade {
-    std::string symbol;
-    bool isBuy;
-    double price;
-    int quantity;
-    int64_t timestamp;
-    std::string strategy;
-};
+    SymbolId intern(const std::string& symbol) {
+        auto it = ids.find(symbol);
+        if (it != ids.end()) return it->second;
+        SymbolId id = static_cast<SymbolId>(names.size());
+        names.push_back(symbol);
+        ids.emplace(symbol, id);
+        return id;
+    }
 
-struct Position {
-    int quantity;
-    double avgEntryPrice;
-    double totalCost;
-    std::vector<Trade> trades;
+    SymbolId find(const std::string& symbol) const {
+        auto it = ids.find(symbol);
+        return (it != ids.end()) ? it->second : INVALID_SYMBOL;
+    }
 
-    Position() : quantity(0), avgEntryPrice(0.0), totalCost(0.0) {}
+    const std::string& name(SymbolId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
 };
 
-struct Signal {
-    enum Action { NONE, BUY, SELL };
-    Action action;
-    double confidence;
-    std::string strategy;
-    double stopLoss;
-    double takeProfit;
-};
+const size_t MAX_UNIVERSE_SIZE = 1000000;
+const size_t MAX_SYMBOL_CHARS = 255;  // tick files store a length byte per name
+
+// SYM00001..SYMnnnnn for scaling runs; ids follow the numbering
+std::vector<std::string> syntheticSymbols(size_t count) {
+    std::vector<std::string> symbols;
+    symbols.reserve(count);
+    char name[16];
+    for (size_t i = 1; i <= count; i++) {
+        std::snprintf(name, sizeof(name), "SYM%05zu", i);
+        symbols.push_back(name);
+    }
+    return symbols;
+}
 
-class MarketDataProvider {
-private:
-    std::map<std::string, MarketData> latestData;
-    std::map<std::string, std::deque<double>> priceHistory;
-    std::mutex dataMutex;
-    std::atomic<bool> running;
-    std::thread dataThread;
-    std::mt19937 gen;
+// One symbol per line; blank lines and '#' comments are skipped
+bool loadSymbolFile(const std::string& path, std::vector<std::string>& symbols, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open file";
+        return false;
+    }
+    std::unordered_map<std::string, size_t> seen;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) continue;
+        size_t last = line.find_last_not_of(" \t\r");
+        std::string symbol = line.substr(first, last - first + 1);
+        if (symbol.size() > MAX_SYMBOL_CHARS) {
+            error = "symbol '" + symbol + "' on line " + std::to_string(lineNumber) + " is too long";
+            return false;
+        }
+        if (!seen.emplace(symbol, lineNumber).second) {
+            error = "duplicate symbol '" + symbol + "' on line " + std::to_string(lineNumber);
+            return false;
+        }
+        symbols.push_back(symbol);
+    }
+    if (symbols.empty()) {
+        error = "no symbols";
+        return false;
+    }
+    if (symbols.size() > MAX_UNIVERSE_SIZE) {
+        error = "more than " + std::to_string(MAX_UNIVERSE_SIZE) + " symbols";
+        return false;
+    }
+    return true;
+}
 
-    void simulateData() {
-        std::map<std::string, double> prices;
-        std::map<std::string, double> volatility;
-        std::map<std::string, double> drift;
+const size_t CACHE_LINE = 64;
 
-        for (size_t i = 0; i < ALL_STOCKS.size(); i++) {
-            prices[ALL_STOCKS[i]] = 100.0 + (gen() % 400);
-            volatility[ALL_STOCKS[i]] = 0.3 + (gen() % 15) / 10.0; // Reduced volatility
-            drift[ALL_STOCKS[i]] = (gen() % 100 - 50) / 20000.0; // Reduced drift
-        }
+// Monotonic clock for latency measurement (not wall time)
+inline int64_t monotonicNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-        while (running) {
-            std::lock_guard<std::mutex> lock(dataMutex);
-            auto now = std::chrono::system_clock::now().time_since_epoch().count();
+// Raw cycle counter for hot-path stamps; falls back to steady_clock nanoseconds
+inline uint64_t cycleCounter() {
+#ifdef HFT_HAS_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(monotonicNanos());
+#endif
+}
 
-            for (size_t i = 0; i < ALL_STOCKS.size(); i++) {
-                std::string symbol = ALL_STOCKS[i];
-                double price = prices[symbol];
-                double vol = volatility[symbol];
-                double d = drift[symbol];
+std::atomic<double> nanosPerCycle(1.0);
+
+// Measures the cycle counter against steady_clock; call once at startup
+void calibrateCycleCounter() {
+#ifdef HFT_HAS_RDTSC
+    int64_t t0 = monotonicNanos();
+    uint64_t c0 = cycleCounter();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int64_t t1 = monotonicNanos();
+    uint64_t c1 = cycleCounter();
+    if (c1 > c0) nanosPerCycle = static_cast<double>(t1 - t0) / static_cast<double>(c1 - c0);
+#endif
+}
 
-                std::normal_distribution<double> dist(0, vol);
-                double randomChange = dist(gen) * 0.0008; // Reduced change magnitude
-                price = price * (1.0 + randomChange + d);
-                prices[symbol] = price;
+inline uint64_t cyclesToNanos(uint64_t cycles) {
+    return static_cast<uint64_t>(cycles * nanosPerCycle.load(std::memory_order_relaxed));
+}
 
-                double spreadPct = 0.0001;
-                MarketData data;
-                data.symbol = symbol;
-                data.bid = price * (1.0 - spreadPct);
-                data.ask = price * (1.0 + spreadPct);
-                data.last = price;
-                data.volume = 1000000 + gen() % 500000;
-                data.timestamp = now;
+inline int highestBit(uint64_t v) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return static_cast<int>(index);
+#elif defined(__GNUC__)
+    return 63 - __builtin_clzll(v);
+#else
+    int bit = 0;
+    while (v >>= 1) bit++;
+    return bit;
+#endif
+}
 
-                latestData[symbol] = data;
-                priceHistory[symbol].push_back(price);
-                if (priceHistory[symbol].size() > 200) {
-                    priceHistory[symbol].pop_front();
-                }
+// A count with one writing thread that any thread may read. The relaxed
+// load and store compile to plain moves, so bumping it costs what a
+// uint64_t would and never issues a locked instruction.
+class StatCounter {
+private:
+    std::atomic<uint64_t> value;
 
-                if (gen() % 500 == 0) {
-                    drift[symbol] = (gen() % 100 - 50) / 20000.0;
-                }
-            }
+public:
+    StatCounter() : value(0) {}
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        }
+    void add(uint64_t by = 1) { value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+// HDR-style log-linear histogram of nanosecond latencies: 32 linear
+// sub-buckets per power of two, so any recorded value is within ~3% of its
+// bucket. Single writer; counts are relaxed atomics so another thread can
+// take a snapshot at any time without locking.
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 5;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS];
+    std::atomic<uint64_t> maxValue;
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t by) {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
     }
 
 public:
-    MarketDataProvider() : running(false), gen(std::random_device{}()) {}
+    LatencyHistogram() : maxValue(0) {
+        for (int i = 0; i < BUCKETS; i++) counts[i].store(0, std::memory_order_relaxed);
+    }
 
-    void start() {
-        running = true;
-        dataThread = std::thread(&MarketDataProvider::simulateData, this);
+    static int bucketFor(uint64_t value) {
+        if (value < static_cast<uint64_t>(SUB_COUNT)) return static_cast<int>(value);
+        int shift = highestBit(value) - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + static_cast<int>((value >> shift) - SUB_COUNT);
     }
 
-    MarketData getData(const std::string& symbol) {
-        std::lock_guard<std::mutex> lock(dataMutex);
-        return latestData[symbol];
+    // Upper bound of the values that land in a bucket
+    static uint64_t bucketValue(int bucket) {
+        if (bucket < SUB_COUNT) return static_cast<uint64_t>(bucket);
+        int shift = bucket / SUB_COUNT - 1;
+        uint64_t base = static_cast<uint64_t>(bucket % SUB_COUNT + SUB_COUNT) << shift;
+        return base + ((uint64_t(1) << shift) - 1);
     }
 
-    std::vector<double> getHistory(const std::string& symbol) {
-        std::lock_guard<std::mutex> lock(dataMutex);
-        std::vector<double> result;
-        if (priceHistory.find(symbol) != priceHistory.end()) {
-            const std::deque<double>& hist = priceHistory[symbol];
-            for (size_t i = 0; i < hist.size(); i++) {
-                result.push_back(hist[i]);
-            }
+    void record(uint64_t nanos) {
+        bump(counts[bucketFor(nanos)], 1);
+        if (nanos > maxValue.load(std::memory_order_relaxed)) {
+            maxValue.store(nanos, std::memory_order_relaxed);
         }
-        return result;
     }
 
-    ~MarketDataProvider() {
-        running = false;
-        if (dataThread.joinable()) dataThread.join();
-    }
+    uint64_t count(int bucket) const { return counts[bucket].load(std::memory_order_relaxed); }
+    uint64_t max() const { return maxValue.load(std::memory_order_relaxed); }
 };
 
-class TradingEngine {
-private:
-    std::map<std::string, Position> positions;
-    double cash;
-    double initialCash;
-    std::mutex execMutex;
-    int tradeCount;
-    int winningTrades;
-    int losingTrades;
-    std::vector<Trade> allTrades;
-    double totalRealizedPnL;
+// Merged, non-atomic copy of one or more histograms for reporting
+struct LatencySnapshot {
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t maxValue;
 
-public:
-    TradingEngine(double capital) : cash(capital), initialCash(capital),
-        tradeCount(0), winningTrades(0),
-        losingTrades(0), totalRealizedPnL(0.0) {
+    LatencySnapshot() : counts(LatencyHistogram::BUCKETS, 0), total(0), maxValue(0) {}
+
+    void merge(const LatencyHistogram& hist) {
+        for (int i = 0; i < LatencyHistogram::BUCKETS; i++) {
+            uint64_t c = hist.count(i);
+            counts[i] += c;
+            total += c;
+        }
+        maxValue = std::max(maxValue, hist.max());
     }
 
-    bool executeBuy(const std::string& symbol, double price, int quantity, const std::string& strategy) {
-        std::lock_guard<std::mutex> lock(execMutex);
+    uint64_t percentile(double pct) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(pct / 100.0 * total));
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < LatencyHistogram::BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(LatencyHistogram::bucketValue(i), maxValue);
+        }
+        return maxValue;
+    }
+};
 
-        double cost = price * quantity;
-        double commission = cost * 0.001;
-        double totalCost = cost + commission;
+enum LatencyStage {
+    STAGE_FEED_TO_STRATEGY,  // feed publish -> strategy evaluation starts
+    STAGE_STRATEGY,          // time spent in TradingStrategy::analyze for one tick
+    STAGE_RISK,              // time spent in RiskGate::approve for one order
+    STAGE_BATCH_SIGNALS,     // one analyzeAll pass over the whole universe
+    STAGE_TICK_TO_DECISION,  // feed publish -> tick fully handled
+    STAGE_TICK_TO_TRADE,     // feed publish -> executeBuy/executeSell returned a fill
+    STAGE_TRIGGER_TO_FILL,   // resting stop/target crossed -> exit filled
+    LATENCY_STAGE_COUNT
+};
 
-        if (cash < totalCost) return false;
+const char* latencyStageName(int stage) {
+    switch (stage) {
+    case STAGE_FEED_TO_STRATEGY: return "Feed->Strategy";
+    case STAGE_STRATEGY: return "Strategy";
+    case STAGE_RISK: return "Risk";
+    case STAGE_BATCH_SIGNALS: return "Batch signals";
+    case STAGE_TICK_TO_DECISION: return "Tick->Decision";
+    case STAGE_TICK_TO_TRADE: return "Tick->Trade";
+    case STAGE_TRIGGER_TO_FILL: return "Trigger->Fill";
+    }
+    return "Unknown";
+}
 
-        Position& pos = positions[symbol];
+// The stage as a metric label
+const char* latencyStageKey(int stage) {
+    switch (stage) {
+    case STAGE_FEED_TO_STRATEGY: return "feed_to_strategy";
+    case STAGE_STRATEGY: return "strategy";
+    case STAGE_RISK: return "risk";
+    case STAGE_BATCH_SIGNALS: return "batch_signals";
+    case STAGE_TICK_TO_DECISION: return "tick_to_decision";
+    case STAGE_TICK_TO_TRADE: return "tick_to_trade";
+    case STAGE_TRIGGER_TO_FILL: return "trigger_to_fill";
+    }
+    return "unknown";
+}
 
-        Trade trade;
-        trade.symbol = symbol;
-        trade.isBuy = true;
-        trade.price = price;
-        trade.quantity = quantity;
-        trade.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
-        trade.strategy = strategy;
+// One set of stage histograms per recording thread, so stamps never contend
+struct ThreadLatency {
+    LatencyHistogram stages[LATENCY_STAGE_COUNT];
 
-        pos.trades.push_back(trade);
-        pos.totalCost += totalCost;
-        pos.quantity += quantity;
-        pos.avgEntryPrice = pos.totalCost / pos.quantity;
+    void record(LatencyStage stage, uint64_t startCycles, uint64_t endCycles) {
+        stages[stage].record(cyclesToNanos(endCycles - startCycles));
+    }
+};
 
-        cash -= totalCost;
-        tradeCount++;
-        allTrades.push_back(trade);
+void printLatencyReport(const std::vector<std::unique_ptr<ThreadLatency>>& threads) {
+    std::cout << Color::BOLD << "Latency (us)           p50      p99    p99.9      max    count\n" << Color::RESET;
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        LatencySnapshot snap;
+        for (size_t t = 0; t < threads.size(); t++) {
+            snap.merge(threads[t]->stages[stage]);
+        }
+        std::cout << "  " << std::left << std::setw(16) << latencyStageName(stage) << std::right
+            << std::fixed << std::setprecision(1)
+            << std::setw(9) << snap.percentile(50.0) / 1000.0
+            << std::setw(9) << snap.percentile(99.0) / 1000.0
+            << std::setw(9) << snap.percentile(99.9) / 1000.0
+            << std::setw(9) << snap.maxValue / 1000.0
+            << std::setw(9) << snap.total << "\n";
+    }
+}
 
-        std::cout << Color::GREEN << "[" << getCurrentTime() << "] BUY  "
-            << std::setw(6) << symbol << " " << std::setw(3) << quantity
-            << " @ $" << std::fixed << std::setprecision(2) << price
-            << " | Cost: $" << std::setprecision(2) << totalCost
-            << " (" << strategy << ")" << Color::RESET << "\n";
+// Scoped cycle accounting for finding hotspots, built with -DHFT_PROFILE.
+// HFT_PROFILE_SCOPE(zone) charges the rest of the enclosing block to zone
+// and HFT_PROFILE_STRATEGY(id) charges it to one strategy's analyze. Each
+// thread counts into its own slot, so a scope is two cycle reads and two
+// uncontended adds. -DHFT_PROFILE_ITT also opens an ITT task per scope for
+// VTune's timeline (link ittnotify). Without HFT_PROFILE both macros
+// expand to nothing.
+enum ProfileZone {
+    PROFILE_FEED_GENERATE,  // simulator: new prices for one universe step
+    PROFILE_FEED_DECODE,    // one feed packet, including the quotes it publishes
+    PROFILE_HISTORY,        // quote, history, indicators and book for one tick
+    PROFILE_BATCH_SIGNALS,  // one analyzeAll pass
+    PROFILE_STRATEGIES,     // every strategy's analyze for one tick
+    PROFILE_RISK,           // RiskGate::approve
+    PROFILE_EXECUTION,      // the engine booking one fill, lock wait included
+    PROFILE_LOG_ENQUEUE,    // queueing one log record (inside execution)
+    PROFILE_LOG_WRITE,      // the writer thread formatting one record
+    PROFILE_ZONE_COUNT
+};
 
-        return true;
+#ifdef HFT_PROFILE
+const size_t MAX_PROFILE_STRATEGIES = 16;
+const size_t MAX_PROFILE_THREADS = 64;
+
+const char* profileZoneName(int zone) {
+    switch (zone) {
+    case PROFILE_FEED_GENERATE: return "Feed generate";
+    case PROFILE_FEED_DECODE: return "Feed decode";
+    case PROFILE_HISTORY: return "History update";
+    case PROFILE_BATCH_SIGNALS: return "Batch signals";
+    case PROFILE_STRATEGIES: return "Strategies";
+    case PROFILE_RISK: return "Risk";
+    case PROFILE_EXECUTION: return "Execution";
+    case PROFILE_LOG_ENQUEUE: return "Log enqueue";
+    case PROFILE_LOG_WRITE: return "Log write";
     }
+    return "Unknown";
+}
 
-    bool executeSell(const std::string& symbol, double price, int quantity, const std::string& strategy) {
-        std::lock_guard<std::mutex> lock(execMutex);
+struct ProfileCell {
+    StatCounter cycles;
+    StatCounter calls;
+};
 
-        Position& pos = positions[symbol];
-        if (pos.quantity < quantity) return false;
+struct alignas(CACHE_LINE) ProfileCounters {
+    ProfileCell zones[PROFILE_ZONE_COUNT];
+    ProfileCell strategies[MAX_PROFILE_STRATEGIES];
+};
 
-        double revenue = price * quantity;
-        double commission = revenue * 0.001;
-        double netRevenue = revenue - commission;
+ProfileCounters profileSlots[MAX_PROFILE_THREADS];
+std::atomic<size_t> profileThreads(0);
 
-        double costBasis = pos.avgEntryPrice * quantity;
-        double pnl = netRevenue - costBasis;
+// This thread's counters, claimed on first use. Threads past the limit
+// share the last slot and may lose a count to a race.
+inline ProfileCounters& threadProfile() {
+    thread_local ProfileCounters* mine = nullptr;
+    if (mine == nullptr) mine = &profileSlots[std::min(profileThreads.fetch_add(1), MAX_PROFILE_THREADS - 1)];
+    return *mine;
+}
 
-        Trade trade;
-        trade.symbol = symbol;
-        trade.isBuy = false;
-        trade.price = price;
-        trade.quantity = quantity;
-        trade.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
-        trade.strategy = strategy;
+#ifdef HFT_PROFILE_ITT
+__itt_domain* profileDomain() {
+    static __itt_domain* domain = __itt_domain_create("hft");
+    return domain;
+}
 
-        pos.quantity -= quantity;
-        if (pos.quantity > 0) {
-            pos.totalCost = pos.avgEntryPrice * pos.quantity;
-        }
-        else {
-            pos.totalCost = 0;
-            pos.avgEntryPrice = 0;
+__itt_string_handle* profileZoneHandle(int zone) {
+    static __itt_string_handle* handles[PROFILE_ZONE_COUNT] = {};
+    static std::once_flag once;
+    std::call_once(once, [] {
+        for (int z = 0; z < PROFILE_ZONE_COUNT; z++) handles[z] = __itt_string_handle_create(profileZoneName(z));
+    });
+    return handles[zone];
+}
+
+__itt_string_handle* profileStrategyHandle(size_t strategy) {
+    static __itt_string_handle* handles[MAX_PROFILE_STRATEGIES] = {};
+    static std::once_flag once;
+    std::call_once(once, [] {
+        for (size_t j = 0; j < MAX_PROFILE_STRATEGIES; j++) {
+            handles[j] = __itt_string_handle_create(("strategy " + std::to_string(j)).c_str());
         }
+    });
+    return handles[strategy];
+}
+#endif
 
-        cash += netRevenue;
-        totalRealizedPnL += pnl;
-        tradeCount++;
-        allTrades.push_back(trade);
+class ProfileScope {
+private:
+    ProfileCell& cell;
+    uint64_t start;
 
-        if (pnl > 0) {
-            winningTrades++;
+public:
+#ifdef HFT_PROFILE_ITT
+    ProfileScope(ProfileCell& target, __itt_string_handle* task) : cell(target) {
+        __itt_task_begin(profileDomain(), __itt_null, __itt_null, task);
+        start = cycleCounter();
+    }
+#else
+    explicit ProfileScope(ProfileCell& target) : cell(target), start(cycleCounter()) {}
+#endif
+
+    ~ProfileScope() {
+        cell.cycles.add(cycleCounter() - start);
+        cell.calls.add();
+#ifdef HFT_PROFILE_ITT
+        __itt_task_end(profileDomain());
+#endif
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+inline size_t profileStrategySlot(size_t strategy) { return std::min(strategy, MAX_PROFILE_STRATEGIES - 1); }
+
+#define HFT_PROFILE_JOIN2(a, b) a##b
+#define HFT_PROFILE_JOIN(a, b) HFT_PROFILE_JOIN2(a, b)
+#ifdef HFT_PROFILE_ITT
+#define HFT_PROFILE_SCOPE(zone) \
+    ProfileScope HFT_PROFILE_JOIN(profileScope, __LINE__)(threadProfile().zones[zone], profileZoneHandle(zone))
+#define HFT_PROFILE_STRATEGY(id) \
+    ProfileScope HFT_PROFILE_JOIN(profileScope, __LINE__)(threadProfile().strategies[profileStrategySlot(id)], \
+        profileStrategyHandle(profileStrategySlot(id)))
+#else
+#define HFT_PROFILE_SCOPE(zone) ProfileScope HFT_PROFILE_JOIN(profileScope, __LINE__)(threadProfile().zones[zone])
+#define HFT_PROFILE_STRATEGY(id) \
+    ProfileScope HFT_PROFILE_JOIN(profileScope, __LINE__)(threadProfile().strategies[profileStrategySlot(id)])
+#endif
+
+// Totals across threads. ns/tick spreads a zone over every tick handled,
+// so the strategy, risk and execution rows add up to the decision cost.
+void printProfileReport(const std::vector<std::string>& strategyNames, uint64_t ticks) {
+    size_t threads = std::min(profileThreads.load(), MAX_PROFILE_THREADS);
+    std::cout << Color::BOLD << "Profile                     calls    total ms   ns/call   ns/tick\n" << Color::RESET;
+    auto row = [ticks, threads](const std::string& name, int indent, size_t zone, bool strategy) {
+        uint64_t cycles = 0, calls = 0;
+        for (size_t t = 0; t < threads; t++) {
+            const ProfileCell& cell = strategy ? profileSlots[t].strategies[zone] : profileSlots[t].zones[zone];
+            cycles += cell.cycles.get();
+            calls += cell.calls.get();
         }
-        else {
-            losingTrades++;
+        if (calls == 0) return;
+        double nanos = static_cast<double>(cyclesToNanos(cycles));
+        std::cout << std::string(2 + indent, ' ') << std::left << std::setw(22 - indent) << name << std::right
+            << std::setw(10) << calls << std::fixed << std::setprecision(1)
+            << std::setw(12) << nanos / 1e6 << std::setw(10) << nanos / calls
+            << std::setw(10) << (ticks > 0 ? nanos / ticks : 0.0) << "\n";
+    };
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+        row(profileZoneName(zone), zone == PROFILE_LOG_ENQUEUE ? 2 : 0, static_cast<size_t>(zone), false);
+        if (zone != PROFILE_STRATEGIES) continue;
+        for (size_t j = 0; j < MAX_PROFILE_STRATEGIES; j++) {
+            std::string name = j < strategyNames.size() ? strategyNames[j] : "strategy " + std::to_string(j);
+            if (j == MAX_PROFILE_STRATEGIES - 1 && strategyNames.size() > MAX_PROFILE_STRATEGIES) name = "(the rest)";
+            row(name, 2, j, true);
         }
+    }
+}
+#else
+#define HFT_PROFILE_SCOPE(zone)
+#define HFT_PROFILE_STRATEGY(id)
+#endif
+
+// Wall clock in nanoseconds since the epoch, independent of system_clock's tick period
+inline int64_t wallClockNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
 
-        std::string pnlColor = (pnl >= 0) ? Color::GREEN : Color::RED;
-        std::cout << Color::RED << "[" << getCurrentTime() << "] SELL "
-            << std::setw(6) << symbol << " " << std::setw(3) << quantity
-            << " @ $" << std::fixed << std::setprecision(2) << price
-            << " | " << pnlColor << "P&L: $" << std::setprecision(2) << pnl
-            << Color::RESET << " (" << strategy << ")" << Color::RESET << "\n";
+std::string formatTime(int64_t wallNanos) {
+    std::time_t time = static_cast<std::time_t>(wallNanos / 1000000000);
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&time), "%H:%M:%S");
+    return ss.str();
+}
 
-        return true;
-    }
+struct MarketData {
+    SymbolId symbol;
+    double bid;
+    double ask;
+    double last;
+    int64_t volume;
+    int64_t timestamp;
 
-    Position getPosition(const std::string& symbol) {
-        std::lock_guard<std::mutex> lock(execMutex);
-        return positions[symbol];
-    }
+    double spread() const { return ask - bid; }
+    double mid() const { return (bid + ask) / 2.0; }
+    bool valid() const { return timestamp != 0; }
+};
 
-    double getCash() {
-        std::lock_guard<std::mutex> lock(execMutex);
-        return cash;
+// Structure-of-arrays quote store indexed by SymbolId.
+// Each symbol is published under its own seqlock: a single writer bumps the
+// sequence to odd, stores the fields, then bumps it back to even. Readers
+// never block and simply retry if they observed a write in progress.
+class QuoteStore {
+private:
+    std::vector<std::atomic<uint32_t>> seq;
+    std::vector<std::atomic<double>> bid;
+    std::vector<std::atomic<double>> ask;
+    std::vector<std::atomic<double>> last;
+    std::vector<std::atomic<int64_t>> volume;
+    std::vector<std::atomic<int64_t>> timestamp;
+
+public:
+    explicit QuoteStore(size_t n) : seq(n), bid(n), ask(n), last(n),
+        volume(n), timestamp(n) {
+        for (size_t i = 0; i < n; i++) {
+            seq[i].store(0, std::memory_order_relaxed);
+            bid[i].store(0.0, std::memory_order_relaxed);
+            ask[i].store(0.0, std::memory_order_relaxed);
+            last[i].store(0.0, std::memory_order_relaxed);
+            volume[i].store(0, std::memory_order_relaxed);
+            timestamp[i].store(0, std::memory_order_relaxed);
+        }
     }
 
-    double getPortfolioValue(const std::map<std::string, double>& currentPrices) {
-        std::lock_guard<std::mutex> lock(execMutex);
-        double total = cash;
+    // Writer side; must only be called from the feed thread
+    void set(const MarketData& data) {
+        SymbolId id = data.symbol;
+        uint32_t version = seq[id].load(std::memory_order_relaxed);
+        seq[id].store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
 
-        for (auto it = positions.begin(); it != positions.end(); ++it) {
-            std::string symbol = it->first;
-            Position pos = it->second;
+        bid[id].store(data.bid, std::memory_order_relaxed);
+        ask[id].store(data.ask, std::memory_order_relaxed);
+        last[id].store(data.last, std::memory_order_relaxed);
+        volume[id].store(data.volume, std::memory_order_relaxed);
+        timestamp[id].store(data.timestamp, std::memory_order_relaxed);
 
-            if (pos.quantity > 0 && currentPrices.find(symbol) != currentPrices.end()) {
-                double currentPrice = currentPrices.at(symbol);
-                total += currentPrice * pos.quantity;
+        seq[id].store(version + 2, std::memory_order_release);
+    }
+
+    // Returns the number of retries needed to obtain a consistent snapshot
+    uint32_t get(SymbolId id, MarketData& data) const {
+        uint32_t retries = 0;
+        data.symbol = id;
+        while (true) {
+            uint32_t before = seq[id].load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                data.bid = bid[id].load(std::memory_order_relaxed);
+                data.ask = ask[id].load(std::memory_order_relaxed);
+                data.last = last[id].load(std::memory_order_relaxed);
+                data.volume = volume[id].load(std::memory_order_relaxed);
+                data.timestamp = timestamp[id].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq[id].load(std::memory_order_relaxed) == before) return retries;
             }
+            retries++;
         }
-
-        return total;
     }
 
-    double getUnrealizedPnL(const std::map<std::string, double>& currentPrices) {
-        std::lock_guard<std::mutex> lock(execMutex);
-        double unrealized = 0;
+    size_t size() const { return seq.size(); }
+};
 
-        for (auto it = positions.begin(); it != positions.end(); ++it) {
-            std::string symbol = it->first;
-            Position pos = it->second;
+struct ContentionStats {
+    uint64_t quoteRetries;      // seqlock reads that raced the feed writer
+};
 
-            if (pos.quantity > 0 && currentPrices.find(symbol) != currentPrices.end()) {
-                double currentPrice = currentPrices.at(symbol);
-                double marketValue = currentPrice * pos.quantity;
-                double costBasis = pos.avgEntryPrice * pos.quantity;
-                unrealized += (marketValue - costBasis);
-            }
-        }
+const size_t DEFAULT_HISTORY_WINDOW = 200;
+const size_t MIN_DECISION_HISTORY = 50;  // prices a symbol needs before the strategies see it
+
+// Non-owning, read-only view over a contiguous run of prices, oldest first
+class PriceWindow {
+private:
+    const double* ptr;
+    size_t len;
+    uint64_t pushed;  // prices the store had taken when the view was made
+
+public:
+    PriceWindow() : ptr(nullptr), len(0), pushed(0) {}
+    PriceWindow(const double* data, size_t size, uint64_t count = 0) : ptr(data), len(size), pushed(count) {}
+
+    const double& operator[](size_t i) const { return ptr[i]; }
+    const double* begin() const { return ptr; }
+    const double* end() const { return ptr + len; }
+    const double* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    uint64_t pushCount() const { return pushed; }
+};
 
-        return unrealized;
+// Per-symbol power-of-two ring buffers for price history.
+// Every price is written twice, at slot and slot + capacity, so the most recent
+// window is always one contiguous run and views need no copying or wrap logic.
+// The capacity is at least twice the window, so a reader holding a view is
+// safe for (capacity - window) >= window further ticks before the writer can
+// reach the oldest slot it is reading.
+//
+// Unlike the quote seqlock, readers do not re-check after reading: a view is
+// used across a whole strategy pass, and a retry there would cost more than
+// the slack. The design assumes no reader holds a view for that many ticks
+// of its symbol. A shard descheduled under --tick-interval-us=0 could break
+// that, so debug builds assert intact() once a view has been used.
+class HistoryStore {
+private:
+    size_t window;
+    size_t capacity;
+    size_t mask;
+    std::vector<double> storage;
+    std::vector<std::atomic<uint64_t>> counts;
+
+    static size_t capacityFor(size_t window) {
+        size_t cap = 1;
+        while (cap < 2 * window) cap <<= 1;
+        return cap;
     }
 
-    double getRealizedPnL() {
-        std::lock_guard<std::mutex> lock(execMutex);
-        return totalRealizedPnL;
+public:
+    HistoryStore(size_t symbols, size_t windowLength) : window(windowLength),
+        capacity(capacityFor(windowLength)), mask(capacity - 1),
+        storage(symbols * capacity * 2, 0.0), counts(symbols) {
+        for (size_t i = 0; i < symbols; i++) {
+            counts[i].store(0, std::memory_order_relaxed);
+        }
     }
 
-    double getTotalPnL(const std::map<std::string, double>& currentPrices) {
-        return totalRealizedPnL + getUnrealizedPnL(currentPrices);
+    // Writer side; must only be called from the feed thread
+    void push(SymbolId id, double price) {
+        uint64_t count = counts[id].load(std::memory_order_relaxed);
+        double* ring = &storage[id * capacity * 2];
+        size_t slot = static_cast<size_t>(count) & mask;
+        ring[slot] = price;
+        ring[slot + capacity] = price;
+        counts[id].store(count + 1, std::memory_order_release);
     }
 
-    int getTradeCount() { return tradeCount; }
-    int getOpenPositions() {
-        std::lock_guard<std::mutex> lock(execMutex);
-        int count = 0;
-        for (auto it = positions.begin(); it != positions.end(); ++it) {
-            if (it->second.quantity > 0) count++;
-        }
-        return count;
+    PriceWindow view(SymbolId id) const {
+        uint64_t count = counts[id].load(std::memory_order_acquire);
+        size_t n = static_cast<size_t>(std::min<uint64_t>(count, window));
+        size_t start = static_cast<size_t>(count - n) & mask;
+        return PriceWindow(&storage[id * capacity * 2 + start], n, count);
     }
 
-    void printSummary(const std::map<std::string, double>& currentPrices) {
-        std::lock_guard<std::mutex> lock(execMutex);
+    // False once the writer has overwritten any price the view covers
+    bool intact(SymbolId id, const PriceWindow& w) const {
+        uint64_t count = counts[id].load(std::memory_order_acquire);
+        return count - w.pushCount() <= capacity - w.size();
+    }
 
-        std::cout << "\n" << Color::BOLD << Color::CYAN;
-        std::cout << "============================================================\n";
-        std::cout << "                   TRADING SUMMARY                          \n";
-        std::cout << "============================================================\n";
-        std::cout << Color::RESET;
+    size_t windowLength() const { return window; }
+};
 
-        double portfolioValue = cash;
-        double unrealizedPnL = 0;
+struct Trade {
+    SymbolId symbol;
+    int quantity;
+    double price;
+    int64_t timestamp;
+    StrategyId strategy;
+    bool isBuy;
+};
 
-        for (auto it = positions.begin(); it != positions.end(); ++it) {
-            std::string symbol = it->first;
-            Position pos = it->second;
+// Plain position state, handed out by value; fill history lives in the TradeJournal
+struct PositionView {
+    int quantity;
+    double avgEntryPrice;
+    double totalCost;
 
-            if (pos.quantity > 0 && currentPrices.find(symbol) != currentPrices.end()) {
-                double currentPrice = currentPrices.at(symbol);
-                double marketValue = currentPrice * pos.quantity;
-                portfolioValue += marketValue;
-                unrealizedPnL += (marketValue - pos.avgEntryPrice * pos.quantity);
-            }
-        }
+    PositionView() : quantity(0), avgEntryPrice(0.0), totalCost(0.0) {}
+};
 
-        double totalPnL = totalRealizedPnL + unrealizedPnL;
-        double returnPct = (totalPnL / initialCash) * 100;
+// signals[i] is always produced by strategy i, so no name is carried
+struct Signal {
+    enum Action { NONE, BUY, SELL };
+    Action action;
+    double confidence;
+    double stopLoss;
+    double takeProfit;
+};
 
-        std::cout << Color::BOLD << "Initial Capital:      " << Color::RESET
-            << "$" << std::fixed << std::setprecision(2) << initialCash << "\n";
-        std::cout << Color::BOLD << "Final Portfolio Value:" << Color::RESET
-            << " $" << portfolioValue << "\n";
-        std::cout << Color::BOLD << "Cash Remaining:       " << Color::RESET
-            << "$" << cash << "\n\n";
+static_assert(std::is_trivially_copyable<Trade>::value, "Trade must stay POD");
+static_assert(std::is_trivially_copyable<Signal>::value, "Signal must stay POD");
 
-        std::cout << Color::BOLD << "Realized P&L:         " << Color::RESET;
-        if (totalRealizedPnL >= 0) {
-            std::cout << Color::GREEN << "+$" << totalRealizedPnL << Color::RESET;
-        }
-        else {
-            std::cout << Color::RED << "$" << totalRealizedPnL << Color::RESET;
-        }
-        std::cout << "\n";
+const size_t TRADE_JOURNAL_CHUNK = 65536;
+const size_t TRADE_JOURNAL_MAX_CHUNKS = 1024;
 
-        std::cout << Color::BOLD << "Unrealized P&L:       " << Color::RESET;
-        if (unrealizedPnL >= 0) {
-            std::cout << Color::GREEN << "+$" << unrealizedPnL << Color::RESET;
-        }
-        else {
-            std::cout << Color::RED << "$" << unrealizedPnL << Color::RESET;
-        }
-        std::cout << "\n";
+// Append-only arena of fills. Trades live in fixed chunks that are never
+// moved, so appending only allocates once every TRADE_JOURNAL_CHUNK fills
+// and references into the journal stay valid.
+class TradeJournal {
+private:
+    std::vector<std::unique_ptr<Trade[]>> chunks;
+    size_t count;
 
-        std::cout << Color::BOLD << "Total P&L:            " << Color::RESET;
-        if (totalPnL >= 0) {
-            std::cout << Color::GREEN << "+$" << totalPnL << " (+" << std::fixed << std::setprecision(2) << returnPct << "%)" << Color::RESET;
-        }
-        else {
-            std::cout << Color::RED << "$" << totalPnL << " (" << std::fixed << std::setprecision(2) << returnPct << "%)" << Color::RESET;
+public:
+    TradeJournal() : count(0) {
+        chunks.reserve(TRADE_JOURNAL_MAX_CHUNKS);
+        chunks.push_back(std::unique_ptr<Trade[]>(new Trade[TRADE_JOURNAL_CHUNK]));
+    }
+
+    void append(const Trade& trade) {
+        if (count == chunks.size() * TRADE_JOURNAL_CHUNK) {
+            chunks.push_back(std::unique_ptr<Trade[]>(new Trade[TRADE_JOURNAL_CHUNK]));
         }
-        std::cout << "\n\n";
+        chunks[count / TRADE_JOURNAL_CHUNK][count % TRADE_JOURNAL_CHUNK] = trade;
+        count++;
+    }
 
-        std::cout << Color::BOLD << "Total Trades:         " << Color::RESET << tradeCount << "\n";
-        std::cout << Color::BOLD << "Winning Trades:       " << Color::RESET
-            << Color::GREEN << winningTrades << Color::RESET << "\n";
-        std::cout << Color::BOLD << "Losing Trades:        " << Color::RESET
-            << Color::RED << losingTrades << Color::RESET << "\n";
+    const Trade& operator[](size_t i) const {
+        return chunks[i / TRADE_JOURNAL_CHUNK][i % TRADE_JOURNAL_CHUNK];
+    }
 
-        if (winningTrades + losingTrades > 0) {
-            double winRate = (static_cast<double>(winningTrades) / (winningTrades + losingTrades)) * 100;
-            std::cout << Color::BOLD << "Win Rate:             " << Color::RESET
-                << std::setprecision(1) << winRate << "%\n";
-        }
+    size_t size() const { return count; }
+    size_t chunkCount() const { return chunks.size(); }
+};
 
-        int openPos = 0;
-        for (auto it = positions.begin(); it != positions.end(); ++it) {
-            if (it->second.quantity > 0) openPos++;
-        }
+// Single-writer seqlock around an arbitrary trivially copyable value,
+// stored as relaxed atomic words so concurrent readers are race-free
+template <typename T>
+class SeqlockSlot {
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "SeqlockSlot requires a POD value");
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
 
-        if (openPos > 0) {
-            std::cout << "\n" << Color::BOLD << Color::YELLOW << "Open Positions: " << openPos << "\n" << Color::RESET;
-            for (auto it = positions.begin(); it != positions.end(); ++it) {
-                std::string symbol = it->first;
-                Position pos = it->second;
-                if (pos.quantity > 0 && currentPrices.find(symbol) != currentPrices.end()) {
-                    double currentPrice = currentPrices.at(symbol);
-                    double posUnrealized = (currentPrice - pos.avgEntryPrice) * pos.quantity;
-                    std::string posColor = (posUnrealized >= 0) ? Color::GREEN : Color::RED;
+    std::atomic<uint32_t> seq;
+    std::atomic<uint64_t> words[WORDS];
 
-                    std::cout << "  " << symbol << ": " << pos.quantity
-                        << " @ $" << std::setprecision(2) << pos.avgEntryPrice
-                        << " (Current: $" << currentPrice << ") "
-                        << posColor << "$" << posUnrealized << Color::RESET << "\n";
-                }
+public:
+    SeqlockSlot() : seq(0) {
+        for (size_t i = 0; i < WORDS; i++) words[i].store(0, std::memory_order_relaxed);
+    }
+
+    void store(const T& value) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        uint32_t version = seq.load(std::memory_order_relaxed);
+        seq.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) words[i].store(buffer[i], std::memory_order_relaxed);
+        seq.store(version + 2, std::memory_order_release);
+    }
+
+    // Returns the number of retries needed to obtain a consistent snapshot
+    uint32_t load(T& value) const {
+        uint64_t buffer[WORDS];
+        uint32_t retries = 0;
+        while (true) {
+            uint32_t before = seq.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                for (size_t i = 0; i < WORDS; i++) buffer[i] = words[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq.load(std::memory_order_relaxed) == before) break;
             }
+            retries++;
         }
-        std::cout << "\n";
+        std::memcpy(&value, buffer, sizeof(T));
+        return retries;
     }
 };
 
-class TradingStrategy {
-protected:
-    std::string name;
+// Fixed-period rolling mean/variance, updated in O(1) per sample with the
+// sliding-window form of Welford's algorithm. The running moments are
+// recomputed exactly each time the ring wraps to keep rounding drift bounded.
+class RollingStats {
+private:
+    std::vector<double> ring;
+    size_t head;
+    size_t count;
+    double mean;
+    double m2;
+
+    void resync() {
+        double sum = 0;
+        for (size_t i = 0; i < ring.size(); i++) sum += ring[i];
+        mean = sum / ring.size();
+        m2 = 0;
+        for (size_t i = 0; i < ring.size(); i++) m2 += (ring[i] - mean) * (ring[i] - mean);
+    }
 
 public:
-    TradingStrategy(const std::string& n) : name(n) {}
-    virtual Signal analyze(const std::string& symbol, const std::vector<double>& prices,
-        const MarketData& current) = 0;
-    std::string getName() const { return name; }
-    virtual ~TradingStrategy() {}
+    explicit RollingStats(size_t period) : ring(period, 0.0), head(0), count(0), mean(0.0), m2(0.0) {}
+
+    void push(double x) {
+        size_t period = ring.size();
+        if (count < period) {
+            count++;
+            double delta = x - mean;
+            mean += delta / count;
+            m2 += delta * (x - mean);
+        }
+        else {
+            double old = ring[head];
+            double oldMean = mean;
+            mean += (x - old) / period;
+            m2 += (x - old) * (x - mean + old - oldMean);
+            if (m2 < 0) m2 = 0;
+        }
+
+        ring[head] = x;
+        head = (head + 1 == period) ? 0 : head + 1;
+        if (head == 0 && count == period) resync();
+    }
+
+    bool full() const { return count == ring.size(); }
+    double average() const { return mean; }
+    double sum() const { return mean * count; }
+    double variance() const { return count > 0 ? m2 / count : 0.0; } // population
+    double stdev() const { return std::sqrt(variance()); }
 };
 
-class ImprovedMeanReversionStrategy : public TradingStrategy {
+// Rolling min/max over a fixed period using monotonic deques kept in flat
+// rings; each sample is pushed and popped at most once, so O(1) amortized
+class RollingExtrema {
+private:
+    struct Entry {
+        uint64_t index;
+        double value;
+    };
+
+    size_t period;
+    uint64_t next;
+    std::vector<Entry> maxRing;
+    std::vector<Entry> minRing;
+    size_t maxFront, maxBack;
+    size_t minFront, minBack;
+
+    size_t wrap(size_t i) const { return (i + 1 == maxRing.size()) ? 0 : i + 1; }
+    size_t unwrap(size_t i) const { return (i == 0) ? maxRing.size() - 1 : i - 1; }
+
 public:
-    ImprovedMeanReversionStrategy() : TradingStrategy("MeanRev") {}
+    explicit RollingExtrema(size_t p) : period(p), next(0), maxRing(p + 2), minRing(p + 2),
+        maxFront(0), maxBack(0), minFront(0), minBack(0) {
+    }
 
-    Signal analyze(const std::string& symbol, const std::vector<double>& prices,
-        const MarketData& current) override {
-        Signal sig;
-        sig.action = Signal::NONE;
-        sig.confidence = 0.0;
-        sig.strategy = name;
+    void push(double x) {
+        while (maxFront != maxBack && maxRing[unwrap(maxBack)].value <= x) maxBack = unwrap(maxBack);
+        maxRing[maxBack] = { next, x };
+        maxBack = wrap(maxBack);
 
-        if (prices.size() < 50) return sig;
+        while (minFront != minBack && minRing[unwrap(minBack)].value >= x) minBack = unwrap(minBack);
+        minRing[minBack] = { next, x };
+        minBack = wrap(minBack);
 
-        double sum = 0;
-        for (size_t i = prices.size() - 50; i < prices.size(); i++) {
-            sum += prices[i];
+        next++;
+        if (next > period) {
+            uint64_t oldest = next - period;
+            if (maxRing[maxFront].index < oldest) maxFront = wrap(maxFront);
+            if (minRing[minFront].index < oldest) minFront = wrap(minFront);
         }
-        double mean = sum / 50;
+    }
+
+    bool empty() const { return next == 0; }
+    double max() const { return maxRing[maxFront].value; }
+    double min() const { return minRing[minFront].value; }
+};
+
+const size_t SHORT_MA_PERIOD = 10;
+const size_t LONG_MA_PERIOD = 30;
+const size_t STATS_PERIOD = 50;
+const size_t BREAKOUT_PERIOD = 30;
+const size_t CONSOLIDATION_PERIOD = 10;
+
+// Snapshot of every indicator the strategies consume, published once per tick
+struct Indicators {
+    uint64_t samples;
+    double shortMA;      // SMA over SHORT_MA_PERIOD
+    double prevShortMA;  // shortMA as of the previous tick
+    double longMA;       // SMA over LONG_MA_PERIOD
+    double mean;         // SMA over STATS_PERIOD
+    double stdev;        // population stdev over STATS_PERIOD
+    double priorHigh;    // max of the BREAKOUT_PERIOD - 1 prices before the latest
+    double priorLow;
+    double recentHigh;   // max of the last CONSOLIDATION_PERIOD prices
+    double recentLow;
+};
 
-        double sqSum = 0;
-        for (size_t i = prices.size() - 50; i < prices.size(); i++) {
-            sqSum += (prices[i] - mean) * (prices[i] - mean);
+// Per-symbol incremental indicator cache. update() runs on the feed thread
+// for each new price; readers get a consistent snapshot via a seqlock.
+class IndicatorCache {
+private:
+    struct State {
+        RollingStats shortStats;
+        RollingStats longStats;
+        RollingStats windowStats;
+        RollingExtrema prior;
+        RollingExtrema recent;
+        uint64_t samples;
+
+        State() : shortStats(SHORT_MA_PERIOD), longStats(LONG_MA_PERIOD), windowStats(STATS_PERIOD),
+            prior(BREAKOUT_PERIOD - 1), recent(CONSOLIDATION_PERIOD), samples(0) {
         }
-        double stdev = std::sqrt(sqSum / 50);
+    };
 
-        if (stdev < 0.01) return sig;
+    std::vector<State> states;
+    std::vector<SeqlockSlot<Indicators>> published;
 
-        double currentPrice = current.mid();
-        double zscore = (currentPrice - mean) / stdev;
+public:
+    explicit IndicatorCache(size_t symbols) : states(symbols), published(symbols) {}
+
+    // Writer side; must only be called from the feed thread
+    void update(SymbolId id, double price) {
+        State& st = states[id];
+
+        Indicators ind;
+        ind.prevShortMA = st.shortStats.average();
+        // The breakout band excludes the latest price, so read it before pushing
+        ind.priorHigh = st.prior.empty() ? price : st.prior.max();
+        ind.priorLow = st.prior.empty() ? price : st.prior.min();
+
+        st.shortStats.push(price);
+        st.longStats.push(price);
+        st.windowStats.push(price);
+        st.prior.push(price);
+        st.recent.push(price);
+        st.samples++;
+
+        ind.samples = st.samples;
+        ind.shortMA = st.shortStats.average();
+        ind.longMA = st.longStats.average();
+        ind.mean = st.windowStats.average();
+        ind.stdev = st.windowStats.stdev();
+        ind.recentHigh = st.recent.max();
+        ind.recentLow = st.recent.min();
+        published[id].store(ind);
+    }
 
-        // Check recent trend to avoid catching falling knives
-        double recentTrend = (prices[prices.size() - 1] - prices[prices.size() - 5]) / prices[prices.size() - 5];
+    uint32_t get(SymbolId id, Indicators& ind) const {
+        return published[id].load(ind);
+    }
+};
 
-        // Balanced thresholds for more trading opportunities
-        if (zscore < -1.8 && recentTrend > -0.012 && stdev / mean < 0.04) {
-            sig.action = Signal::BUY;
-            sig.confidence = 0.85;
-            sig.takeProfit = mean;
-            sig.stopLoss = currentPrice * 0.985;
-        }
-        else if (zscore > 1.8 && recentTrend < 0.012 && stdev / mean < 0.04) {
-            sig.action = Signal::SELL;
-            sig.confidence = 0.85;
-            sig.takeProfit = mean;
-            sig.stopLoss = currentPrice * 1.015;
-        }
+// Structure-of-arrays snapshot of every symbol's quote and indicators, the
+// input to the batch signal kernels. Counts are stored as doubles so every
+// field loads into the same vector lanes.
+struct UniverseFrame {
+    size_t count;
+    std::vector<double> samples;
+    std::vector<double> history;  // PriceWindow::size()
+    std::vector<double> mid;
+    std::vector<double> trend;    // 5-price change over the history window; 0 below 5 prices
+    std::vector<double> mean;
+    std::vector<double> stdev;
+    std::vector<double> shortMA;
+    std::vector<double> prevShortMA;
+    std::vector<double> longMA;
+    std::vector<double> priorHigh;
+    std::vector<double> priorLow;
+    std::vector<double> recentHigh;
+    std::vector<double> recentLow;
+
+    explicit UniverseFrame(size_t symbols) : count(symbols), samples(symbols), history(symbols),
+        mid(symbols), trend(symbols), mean(symbols), stdev(symbols), shortMA(symbols),
+        prevShortMA(symbols), longMA(symbols), priorHigh(symbols), priorLow(symbols),
+        recentHigh(symbols), recentLow(symbols) {
+    }
 
-        return sig;
+    void set(SymbolId id, const MarketData& data, const PriceWindow& prices, const Indicators& ind) {
+        size_t n = prices.size();
+        samples[id] = static_cast<double>(ind.samples);
+        history[id] = static_cast<double>(n);
+        mid[id] = data.mid();
+        trend[id] = n >= 5 ? (prices[n - 1] - prices[n - 5]) / prices[n - 5] : 0.0;
+        mean[id] = ind.mean;
+        stdev[id] = ind.stdev;
+        shortMA[id] = ind.shortMA;
+        prevShortMA[id] = ind.prevShortMA;
+        longMA[id] = ind.longMA;
+        priorHigh[id] = ind.priorHigh;
+        priorLow[id] = ind.priorLow;
+        recentHigh[id] = ind.recentHigh;
+        recentLow[id] = ind.recentLow;
     }
 };
 
-class TrendFollowingStrategy : public TradingStrategy {
+// One bit per symbol
+class SignalMask {
+private:
+    std::vector<uint64_t> words;
+
 public:
-    TrendFollowingStrategy() : TradingStrategy("TrendFollow") {}
+    explicit SignalMask(size_t symbols) : words((symbols + 63) / 64, 0) {}
+
+    void clear() { std::fill(words.begin(), words.end(), 0); }
+    void set(size_t i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    // Ors in up to 4 bits for symbols first..first + 3; first must be a multiple of 4
+    void setBits(size_t first, uint64_t bits) { words[first >> 6] |= bits << (first & 63); }
+    bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+
+    size_t popcount() const {
+        size_t total = 0;
+        for (size_t w = 0; w < words.size(); w++) {
+            for (uint64_t v = words[w]; v != 0; v &= v - 1) total++;
+        }
+        return total;
+    }
+};
 
-    Signal analyze(const std::string& symbol, const std::vector<double>& prices,
-        const MarketData& current) override {
-        Signal sig;
-        sig.action = Signal::NONE;
-        sig.confidence = 0.0;
-        sig.strategy = name;
+// Runtime CPU dispatch for the batch kernels
+enum class KernelIsa { Scalar, Avx2 };
+
+inline bool cpuSupportsAvx2() {
+#if defined(HFT_HAS_AVX2_KERNELS) && defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 1);
+    bool osSaves = (regs[2] & (1 << 27)) != 0 && (regs[2] & (1 << 28)) != 0;
+    if (!osSaves || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#elif defined(HFT_HAS_AVX2_KERNELS)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
 
-        if (prices.size() < 30) return sig;
+KernelIsa detectKernelIsa() {
+    return cpuSupportsAvx2() ? KernelIsa::Avx2 : KernelIsa::Scalar;
+}
 
-        double shortSum = 0;
-        for (size_t i = prices.size() - 10; i < prices.size(); i++) {
-            shortSum += prices[i];
-        }
-        double shortMA = shortSum / 10;
+const char* kernelIsaName(KernelIsa isa) {
+    return isa == KernelIsa::Avx2 ? "avx2" : "scalar";
+}
 
-        double longSum = 0;
-        for (size_t i = prices.size() - 30; i < prices.size(); i++) {
-            longSum += prices[i];
-        }
-        double longMA = longSum / 30;
+// Bounded single-producer/single-consumer ring; capacity rounds up to a power of two
+template <typename T>
+class SpscQueue {
+private:
+    std::vector<T> buffer;
+    size_t mask;
+    alignas(CACHE_LINE) std::atomic<uint64_t> head; // next slot to read, owned by consumer
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail; // next slot to write, owned by producer
+    alignas(CACHE_LINE) uint64_t cachedHead;        // producer's last view of head
+
+    static size_t roundUp(size_t n) {
+        size_t cap = 1;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+public:
+    explicit SpscQueue(size_t capacity) : buffer(roundUp(capacity)), mask(roundUp(capacity) - 1),
+        head(0), tail(0), cachedHead(0) {
+    }
 
-        double prevShortSum = 0;
-        for (size_t i = prices.size() - 11; i < prices.size() - 1; i++) {
-            prevShortSum += prices[i];
+    bool push(const T& item) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead > mask) return false;
         }
-        double prevShortMA = prevShortSum / 10;
+        buffer[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
 
-        bool crossedUp = (prevShortMA <= longMA && shortMA > longMA);
-        bool crossedDown = (prevShortMA >= longMA && shortMA < longMA);
+    bool pop(T& item) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = buffer[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
 
-        double momentum = (shortMA - longMA) / longMA;
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
 
-        // Check for strong momentum
-        double recentMomentum = (prices[prices.size() - 1] - prices[prices.size() - 5]) / prices[prices.size() - 5];
+    size_t size() const {
+        return static_cast<size_t>(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+    }
+};
 
-        if (crossedUp && momentum > 0.003 && recentMomentum > 0) {
-            sig.action = Signal::BUY;
-            sig.confidence = 0.84;
-            sig.takeProfit = current.mid() * 1.015;
-            sig.stopLoss = current.mid() * 0.992;
-        }
-        else if (crossedDown && momentum < -0.003 && recentMomentum < 0) {
-            sig.action = Signal::SELL;
-            sig.confidence = 0.84;
-            sig.takeProfit = current.mid() * 0.985;
-            sig.stopLoss = current.mid() * 1.008;
+// Bounded multi-producer/single-consumer ring (Vyukov). Producers claim a
+// slot with one CAS and never block; push fails when the ring is full.
+template <typename T>
+class MpscQueue {
+private:
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(CACHE_LINE) std::atomic<uint64_t> enqueuePos;
+    alignas(CACHE_LINE) uint64_t dequeuePos;
+
+public:
+    explicit MpscQueue(size_t capacity) : mask(0), enqueuePos(0), dequeuePos(0) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        mask = cap - 1;
+        cells.reset(new Cell[cap]);
+        for (size_t i = 0; i < cap; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const T& item) {
+        uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
         }
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
 
-        return sig;
+    // Single consumer only
+    bool pop(T& item) {
+        Cell& cell = cells[dequeuePos & mask];
+        uint64_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<int64_t>(seq) - static_cast<int64_t>(dequeuePos + 1) < 0) return false;
+        item = cell.data;
+        cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+        dequeuePos++;
+        return true;
     }
 };
 
-class BreakoutStrategy : public TradingStrategy {
-public:
-    BreakoutStrategy() : TradingStrategy("Breakout") {}
+// Thread placement. Pinning and priorities are applied to running threads
+// through their native handles; Linux and Windows are supported, other
+// platforms report the request as unsupported and run unpinned.
+using ThreadHandle = std::thread::native_handle_type;
 
-    Signal analyze(const std::string& symbol, const std::vector<double>& prices,
-        const MarketData& current) override {
-        Signal sig;
-        sig.action = Signal::NONE;
-        sig.confidence = 0.0;
-        sig.strategy = name;
+const int REALTIME_PRIORITY = 80;  // SCHED_FIFO priority for feed and trading threads
 
-        if (prices.size() < 30) return sig;
+enum class ThreadPriority { Normal, Realtime, Background };
 
-        double high = prices[prices.size() - 30];
-        double low = prices[prices.size() - 30];
+ThreadHandle currentThreadHandle() {
+#ifdef _WIN32
+    return GetCurrentThread();
+#else
+    return pthread_self();
+#endif
+}
 
-        for (size_t i = prices.size() - 30; i < prices.size() - 1; i++) {
-            if (prices[i] > high) high = prices[i];
-            if (prices[i] < low) low = prices[i];
-        }
+std::string systemErrorText(int code) {
+#ifdef _WIN32
+    return "error " + std::to_string(code);
+#else
+    return std::strerror(code);
+#endif
+}
 
-        double range = high - low;
-        double currentPrice = current.mid();
+bool pinThread(ThreadHandle handle, int cpu, std::string& error) {
+#if defined(_WIN32)
+    if (cpu < 0 || cpu >= 64) {
+        error = "cpu out of range";
+        return false;
+    }
+    if (SetThreadAffinityMask(handle, DWORD_PTR(1) << cpu) == 0) {
+        error = systemErrorText(static_cast<int>(GetLastError()));
+        return false;
+    }
+    return true;
+#elif defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        error = "cpu out of range";
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(handle, sizeof(set), &set);
+    if (rc != 0) {
+        error = systemErrorText(rc);
+        return false;
+    }
+    return true;
+#else
+    error = "not supported on this platform";
+    return false;
+#endif
+}
+
+// Realtime is SCHED_FIFO on Linux and time-critical priority on Windows;
+// Background keeps housekeeping threads off the hot cores' run queues
+bool setThreadPriority(ThreadHandle handle, ThreadPriority priority, std::string& error) {
+#if defined(_WIN32)
+    int level = THREAD_PRIORITY_NORMAL;
+    if (priority == ThreadPriority::Realtime) level = THREAD_PRIORITY_TIME_CRITICAL;
+    if (priority == ThreadPriority::Background) level = THREAD_PRIORITY_BELOW_NORMAL;
+    if (!SetThreadPriority(handle, level)) {
+        error = systemErrorText(static_cast<int>(GetLastError()));
+        return false;
+    }
+    return true;
+#elif defined(__linux__)
+    sched_param param;
+    param.sched_priority = 0;
+    int policy = SCHED_OTHER;
+    if (priority == ThreadPriority::Realtime) {
+        policy = SCHED_FIFO;
+        param.sched_priority = REALTIME_PRIORITY;
+    }
+    if (priority == ThreadPriority::Background) policy = SCHED_BATCH;
+    int rc = pthread_setschedparam(handle, policy, &param);
+    if (rc != 0) {
+        error = systemErrorText(rc);
+        return false;
+    }
+    return true;
+#else
+    error = "not supported on this platform";
+    return false;
+#endif
+}
 
-        // Check consolidation period before breakout
-        double recentHigh = prices[prices.size() - 10];
-        double recentLow = prices[prices.size() - 10];
-        for (size_t i = prices.size() - 10; i < prices.size(); i++) {
-            if (prices[i] > recentHigh) recentHigh = prices[i];
-            if (prices[i] < recentLow) recentLow = prices[i];
+// NUMA node that owns a CPU, or -1 if unknown
+int cpuNumaNode(int cpu) {
+#if defined(_WIN32)
+    USHORT node = 0;
+    PROCESSOR_NUMBER processor;
+    processor.Group = 0;
+    processor.Number = static_cast<BYTE>(cpu);
+    processor.Reserved = 0;
+    return GetNumaProcessorNodeEx(&processor, &node) ? node : -1;
+#elif defined(__linux__)
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) return -1;
+    int node = -1;
+    while (dirent* entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "node", 4) == 0 && std::isdigit(static_cast<unsigned char>(entry->d_name[4]))) {
+            node = std::atoi(entry->d_name + 4);
+            break;
         }
-        double recentRange = recentHigh - recentLow;
+    }
+    closedir(dir);
+    return node;
+#else
+    return -1;
+#endif
+}
 
-        // Only trade if breakout is significant and follows consolidation
-        if (currentPrice > high && range / high > 0.015 && recentRange / range < 0.65) {
-            sig.action = Signal::BUY;
-            sig.confidence = 0.81;
-            sig.takeProfit = currentPrice * 1.02;
-            sig.stopLoss = high * 0.996;
+// Effective placement as the OS reports it, e.g. "cpu 2 (node 0), SCHED_FIFO 80"
+std::string describeThread(ThreadHandle handle) {
+    std::ostringstream text;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(handle, sizeof(set), &set) == 0) {
+        int count = CPU_COUNT(&set);
+        int first = -1;
+        for (int cpu = 0; cpu < CPU_SETSIZE && first < 0; cpu++) {
+            if (CPU_ISSET(cpu, &set)) first = cpu;
         }
-        else if (currentPrice < low && range / low > 0.015 && recentRange / range < 0.65) {
-            sig.action = Signal::SELL;
-            sig.confidence = 0.81;
-            sig.takeProfit = currentPrice * 0.98;
-            sig.stopLoss = low * 1.004;
+        if (count == 1) {
+            text << "cpu " << first;
+            int node = cpuNumaNode(first);
+            if (node >= 0) text << " (node " << node << ")";
+        }
+        else {
+            text << "any of " << count << " cpus";
         }
-
-        return sig;
     }
-};
+    int policy = 0;
+    sched_param param;
+    if (pthread_getschedparam(handle, &policy, &param) == 0) {
+        if (policy == SCHED_FIFO) text << ", SCHED_FIFO " << param.sched_priority;
+        else if (policy == SCHED_RR) text << ", SCHED_RR " << param.sched_priority;
+        else if (policy == SCHED_BATCH) text << ", SCHED_BATCH";
+        else if (policy == SCHED_IDLE) text << ", SCHED_IDLE";
+        else text << ", SCHED_OTHER";
+    }
+#elif defined(_WIN32)
+    int priority = GetThreadPriority(handle);
+    text << "priority " << priority;
+#else
+    text << "default scheduling";
+#endif
+    return text.str();
+}
 
-class HFTSystem {
+// Pins the calling thread for the lifetime of the object and then restores
+// its previous affinity. Memory first touched meanwhile is allocated on
+// that CPU's NUMA node by the default local-allocation policy.
+class ScopedCpuAffinity {
 private:
-    std::unique_ptr<MarketDataProvider> dataProvider;
-    std::unique_ptr<TradingEngine> engine;
-    std::vector<std::unique_ptr<TradingStrategy>> strategies;
-    std::atomic<bool> running;
-    std::thread tradingThread;
-    std::thread displayThread;
-    std::map<std::string, double> entryPrices;
-    double initialCapital;
+    bool pinned;
+#if defined(_WIN32)
+    DWORD_PTR previous;
+#elif defined(__linux__)
+    cpu_set_t previous;
+#endif
 
-    void tradingLoop() {
-        std::cout << Color::YELLOW << "\n[SYSTEM] Trading engine started - scanning stocks...\n"
-            << Color::RESET << "\n";
+public:
+    explicit ScopedCpuAffinity(int cpu) : pinned(false) {
+        std::string error;
+#if defined(_WIN32)
+        previous = 0;
+        if (cpu >= 0 && cpu < 64) {
+            previous = SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu);
+            pinned = previous != 0;
+        }
+#elif defined(__linux__)
+        CPU_ZERO(&previous);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) == 0) {
+            pinned = pinThread(pthread_self(), cpu, error);
+        }
+#endif
+    }
 
-        while (running) {
-            for (size_t i = 0; i < ALL_STOCKS.size(); i++) {
-                std::string symbol = ALL_STOCKS[i];
-                MarketData current = dataProvider->getData(symbol);
-                std::vector<double> history = dataProvider->getHistory(symbol);
+    ~ScopedCpuAffinity() {
+        if (!pinned) return;
+#if defined(_WIN32)
+        SetThreadAffinityMask(GetCurrentThread(), previous);
+#elif defined(__linux__)
+        pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+#endif
+    }
 
-                if (current.symbol.empty() || history.size() < 50) continue;
+    bool isPinned() const { return pinned; }
 
-                Position pos = engine->getPosition(symbol);
+    ScopedCpuAffinity(const ScopedCpuAffinity&) = delete;
+    ScopedCpuAffinity& operator=(const ScopedCpuAffinity&) = delete;
+};
 
-                // Improved risk management for open positions
-                if (pos.quantity > 0) {
-                    double currentPrice = current.mid();
-                    double pnlPercent = (currentPrice - pos.avgEntryPrice) / pos.avgEntryPrice;
+// A whole decimal number in [0, limit], with nothing after it
+bool parseUnsigned(const std::string& text, uint64_t limit, uint64_t& value) {
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])) || *end != '\0'
+        || parsed > limit) return false;
+    value = parsed;
+    return true;
+}
 
-                    // Balanced stop loss and take profit
-                    if (pnlPercent < -0.018 || pnlPercent > 0.022) {
-                        engine->executeSell(symbol, current.bid, pos.quantity, "StopLoss/TakeProfit");
-                    }
-                }
+bool parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        char* end = nullptr;
+        long cpu = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || cpu < 0 || cpu > 4095) return false;
+        cpus.push_back(static_cast<int>(cpu));
+    }
+    return !cpus.empty();
+}
 
-                // Only enter new positions if we're not overexposed
-                if (pos.quantity == 0) {
-                    for (size_t j = 0; j < strategies.size(); j++) {
-                        Signal signal = strategies[j]->analyze(symbol, history, current);
-
-                        if (signal.action == Signal::BUY && signal.confidence > 0.80) {
-                            double portfolioValue = engine->getCash();
-                            // Balanced position sizing (2% per trade for more activity)
-                            int qty = static_cast<int>((portfolioValue * 0.02) / current.ask);
-
-                            // Allow up to 25 open positions for more trading
-                            if (qty > 0 && engine->getOpenPositions() < 25) {
-                                engine->executeBuy(symbol, current.ask, qty, signal.strategy);
-                                entryPrices[symbol] = current.ask;
-                            }
-                        }
-                        else if (signal.action == Signal::SELL && signal.confidence > 0.80) {
-                            if (pos.quantity > 0) {
-                                engine->executeSell(symbol, current.bid, pos.quantity, signal.strategy);
-                            }
-                        }
-                    }
-                }
-            }
+// How a consumer waits for the next tick
+enum class WaitPolicy { BusySpin, Hybrid, Blocking };
+
+const char* waitPolicyName(WaitPolicy policy) {
+    switch (policy) {
+    case WaitPolicy::BusySpin: return "busy-spin";
+    case WaitPolicy::Hybrid: return "hybrid";
+    case WaitPolicy::Blocking: return "blocking";
+    }
+    return "unknown";
+}
+
+bool parseWaitPolicy(const std::string& text, WaitPolicy& policy) {
+    if (text == "spin") policy = WaitPolicy::BusySpin;
+    else if (text == "hybrid") policy = WaitPolicy::Hybrid;
+    else if (text == "block") policy = WaitPolicy::Blocking;
+    else return false;
+    return true;
+}
+
+struct TickEvent {
+    SymbolId symbol;
+    uint64_t publishCycles; // cycleCounter() when the feed published the tick
+};
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(150));
+// Push channel from the feed to one consumer thread. The producer never
+// blocks: if the consumer falls a full queue behind, the event is dropped
+// and counted. Blocking/hybrid consumers park on a condition variable that
+// the producer only signals when the consumer has announced it is asleep.
+class TickChannel {
+private:
+    SpscQueue<TickEvent> queue;
+    WaitPolicy policy;
+    std::atomic<bool> sleeping;
+    std::mutex waitMutex;
+    std::condition_variable wakeup;
+    std::atomic<uint64_t> dropped;
+
+    static const int SPIN_LIMIT = 2000;
+    static const int YIELD_LIMIT = 50;
+
+    bool park(TickEvent& event) {
+        std::unique_lock<std::mutex> lock(waitMutex);
+        sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool got = queue.pop(event);
+        if (!got) {
+            // Bounded wait so shutdown never hangs on a quiet feed
+            wakeup.wait_for(lock, std::chrono::milliseconds(100));
+            got = queue.pop(event);
         }
+        sleeping.store(false, std::memory_order_relaxed);
+        return got;
     }
 
-    void displayLoop() {
-        while (running) {
-            std::map<std::string, double> prices;
-            for (size_t i = 0; i < ALL_STOCKS.size(); i++) {
-                MarketData data = dataProvider->getData(ALL_STOCKS[i]);
-                if (!data.symbol.empty()) {
-                    prices[ALL_STOCKS[i]] = data.mid();
-                }
-            }
+public:
+    TickChannel(size_t capacity, WaitPolicy waitPolicy) : queue(capacity), policy(waitPolicy),
+        sleeping(false), dropped(0) {
+    }
 
-            double portfolioValue = engine->getPortfolioValue(prices);
-            double totalPnL = portfolioValue - initialCapital;
-            double returnPct = (totalPnL / initialCapital) * 100;
+    // Producer side
+    void publish(const TickEvent& event) {
+        if (!queue.push(event)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (policy == WaitPolicy::BusySpin) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            wakeup.notify_one();
+        }
+    }
 
-            std::cout << "\r" << Color::BOLD << "Portfolio: $"
-                << std::fixed << std::setprecision(2) << portfolioValue
-                << " | P&L: ";
+    // Consumer side; returns false when no tick arrived (e.g. on shutdown)
+    bool next(TickEvent& event, const std::atomic<bool>& running) {
+        if (queue.pop(event)) return true;
 
-            if (totalPnL >= 0) {
-                std::cout << Color::GREEN << "+$" << totalPnL << " (+" << std::setprecision(1) << returnPct << "%)";
+        switch (policy) {
+        case WaitPolicy::BusySpin:
+            while (running) {
+                if (queue.pop(event)) return true;
             }
-            else {
-                std::cout << Color::RED << "$" << totalPnL << " (" << std::setprecision(1) << returnPct << "%)";
+            return false;
+        case WaitPolicy::Hybrid:
+            for (int i = 0; i < SPIN_LIMIT; i++) {
+                if (queue.pop(event)) return true;
             }
-
-            std::cout << Color::RESET << " | Trades: " << engine->getTradeCount()
-                << " | Open: " << engine->getOpenPositions()
-                << "     " << std::flush;
-
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            for (int i = 0; i < YIELD_LIMIT; i++) {
+                std::this_thread::yield();
+                if (queue.pop(event)) return true;
+            }
+            return park(event);
+        case WaitPolicy::Blocking:
+            return park(event);
         }
+        return false;
     }
 
-public:
-    HFTSystem(double capital) : running(false), initialCapital(capital) {
-        dataProvider = std::make_unique<MarketDataProvider>();
-        engine = std::make_unique<TradingEngine>(capital);
+    // Consumer side; drops everything currently queued
+    size_t discardPending() {
+        TickEvent event;
+        size_t discarded = 0;
+        while (queue.pop(event)) discarded++;
+        return discarded;
+    }
 
-        strategies.push_back(std::make_unique<ImprovedMeanReversionStrategy>());
-        strategies.push_back(std::make_unique<TrendFollowingStrategy>());
-        strategies.push_back(std::make_unique<BreakoutStrategy>());
+    void wake() {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        wakeup.notify_all();
     }
 
-    void start() {
-        std::cout << Color::BOLD << Color::GREEN;
-        std::cout << "\n============================================================\n";
-        std::cout << "     ULTRA-EFFICIENT HFT SYSTEM - PROFITABLE EDITION        \n";
-        std::cout << "============================================================\n";
-        std::cout << Color::RESET << "\n";
+    WaitPolicy getPolicy() const { return policy; }
+    uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    size_t depth() const { return queue.size(); }
+};
 
-        std::cout << Color::CYAN << "[INIT] Starting with $"
-            << std::fixed << std::setprecision(2) << initialCapital << " capital\n" << Color::RESET;
-        std::cout << Color::CYAN << "[INIT] Initializing market data for "
-            << ALL_STOCKS.size() << " stocks...\n" << Color::RESET;
+const int64_t TICK_INTERVAL_NANOS = 50000000; // 50 ms between universe updates
 
-        dataProvider->start();
+// Classic draws from mt19937 one tick at a time and is the reference for
+// existing seeds; Fast updates the whole universe as array kernels fed by
+// xoshiro256** and batched Box-Muller normals, for load testing
+enum class FeedGenerator { Classic, Fast };
 
-        std::cout << Color::CYAN << "[INIT] Warming up algorithms...\n" << Color::RESET;
-        std::this_thread::sleep_for(std::chrono::seconds(3));
+const char* feedGeneratorName(FeedGenerator generator) {
+    return generator == FeedGenerator::Fast ? "fast" : "classic";
+}
 
-        std::cout << Color::GREEN << "[READY] System ready - starting trading!\n" << Color::RESET;
-        std::cout << Color::BOLD << "\nActive Strategies:\n" << Color::RESET;
-        for (size_t i = 0; i < strategies.size(); i++) {
-            std::cout << "  - " << Color::MAGENTA << strategies[i]->getName() << Color::RESET << "\n";
-        }
-        std::cout << "\n" << Color::YELLOW << "Press ENTER to stop...\n\n" << Color::RESET;
+bool parseFeedGenerator(const std::string& text, FeedGenerator& generator) {
+    if (text == "classic") generator = FeedGenerator::Classic;
+    else if (text == "fast") generator = FeedGenerator::Fast;
+    else return false;
+    return true;
+}
 
-        running = true;
-        tradingThread = std::thread(&HFTSystem::tradingLoop, this);
-        displayThread = std::thread(&HFTSystem::displayLoop, this);
-    }
+// xoshiro256** (Blackman & Vigna), seeded through splitmix64
+class Xoshiro256 {
+private:
+    uint64_t s[4];
 
-    void stop() {
-        std::cout << "\n\n" << Color::YELLOW << "[STOP] Shutting down trading engine...\n"
-            << Color::RESET;
-        running = false;
-        if (tradingThread.joinable()) tradingThread.join();
-        if (displayThread.joinable()) displayThread.join();
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
 
-        std::map<std::string, double> prices;
-        for (size_t i = 0; i < ALL_STOCKS.size(); i++) {
-            MarketData data = dataProvider->getData(ALL_STOCKS[i]);
-            if (!data.symbol.empty()) {
-                prices[ALL_STOCKS[i]] = data.mid();
-            }
+public:
+    explicit Xoshiro256(uint64_t seed) {
+        for (int i = 0; i < 4; i++) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            s[i] = z ^ (z >> 31);
         }
+    }
 
-        engine->printSummary(prices);
-        std::cout << Color::GREEN << "\n[COMPLETE] Session ended successfully!\n" << Color::RESET;
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
     }
-};
 
-int main() {
-    std::cout << Color::BOLD << Color::CYAN;
-    std::cout << "\n============================================================\n";
-    std::cout << "          HIGH-FREQUENCY TRADING SYSTEM v3.0                \n";
-    std::cout << "============================================================\n";
-    std::cout << Color::RESET << "\n";
+    // Uniform in (0, 1], safe to take the log of
+    double uniform() { return ((next() >> 11) + 1) * (1.0 / 9007199254740992.0); }
 
-    double capital = 0;
-    std::cout << Color::YELLOW << "Enter starting capital (e.g., 100000): $" << Color::RESET;
-    std::cin >> capital;
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    // Uniform integer in [0, bound) by multiply-shift, without modulo bias or a divide
+    uint32_t below(uint32_t bound) {
+        return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+    }
 
-    if (capital < 1000) {
-        std::cout << Color::RED << "Minimum capital is $1,000\n" << Color::RESET;
-        return 1;
+    // Standard normals, two per Box-Muller transform
+    void normals(double* out, size_t n) {
+        const double twoPi = 6.283185307179586;
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            double r = std::sqrt(-2.0 * std::log(uniform()));
+            double theta = twoPi * uniform();
+            out[i] = r * std::cos(theta);
+            out[i + 1] = r * std::sin(theta);
+        }
+        if (i < n) out[i] = std::sqrt(-2.0 * std::log(uniform())) * std::cos(twoPi * uniform());
     }
+};
 
-    HFTSystem system(capital);
-    system.start();
+const double SIM_CHANGE_SCALE = 0.0008;       // Reduced change magnitude
+const double SIM_SPREAD_PCT = 0.0001;
+const uint32_t SIM_DRIFT_CHANGE_ODDS = 500;   // a symbol's drift is redrawn 1 step in 500
+
+// Geometric random walk for every symbol. Fully determined by its seed, so
+// a backtest driven by the same seed replays the same market.
+class GbmSimulator {
+private:
+    FeedGenerator generator;
+    std::mt19937 gen;
+    Xoshiro256 fastGen;
+    std::vector<double> prices;
+    std::vector<double> volatility;
+    std::vector<double> drift;
+    // Fast generator scratch, one entry per symbol
+    std::vector<double> noise;
+    std::vector<double> bids;
+    std::vector<double> asks;
+
+    double randomDrift() {
+        return (static_cast<int>(gen() % 100) - 50) / 20000.0; // Reduced drift
+    }
+
+    double fastDrift() {
+        return (static_cast<int>(fastGen.below(100)) - 50) / 20000.0;
+    }
+
+    template <typename Sink>
+    void classicStep(int64_t timestamp, Sink&& sink) {
+        for (SymbolId id = 0; id < prices.size(); id++) {
+            MarketData data;
+            {
+                HFT_PROFILE_SCOPE(PROFILE_FEED_GENERATE);
+                double price = prices[id];
+                double vol = volatility[id];
+                double d = drift[id];
+
+                std::normal_distribution<double> dist(0, vol);
+                double randomChange = dist(gen) * SIM_CHANGE_SCALE;
+                price = price * (1.0 + randomChange + d);
+                prices[id] = price;
+
+                data.symbol = id;
+                data.bid = price * (1.0 - SIM_SPREAD_PCT);
+                data.ask = price * (1.0 + SIM_SPREAD_PCT);
+                data.last = price;
+                data.volume = 1000000 + gen() % 500000;
+                data.timestamp = timestamp;
+            }
+            sink(data);
+
+            if (gen() % SIM_DRIFT_CHANGE_ODDS == 0) {
+                drift[id] = randomDrift();
+            }
+        }
+    }
+
+    template <typename Sink>
+    void fastStep(int64_t timestamp, Sink&& sink) {
+        size_t n = prices.size();
+        double* p = prices.data();
+        double* bid = bids.data();
+        double* ask = asks.data();
+        {
+            HFT_PROFILE_SCOPE(PROFILE_FEED_GENERATE);
+            fastGen.normals(noise.data(), n);
+
+            // Straight-line array kernel; the compiler vectorizes it
+            const double* z = noise.data();
+            const double* vol = volatility.data();
+            const double* d = drift.data();
+            for (size_t i = 0; i < n; i++) {
+                double price = p[i] * (1.0 + z[i] * vol[i] * SIM_CHANGE_SCALE + d[i]);
+                p[i] = price;
+                bid[i] = price * (1.0 - SIM_SPREAD_PCT);
+                ask[i] = price * (1.0 + SIM_SPREAD_PCT);
+            }
+        }
+
+        for (SymbolId id = 0; id < n; id++) {
+            MarketData data;
+            data.symbol = id;
+            data.bid = bid[id];
+            data.ask = ask[id];
+            data.last = p[id];
+            data.volume = 1000000 + fastGen.below(500000);
+            data.timestamp = timestamp;
+            sink(data);
+        }
+
+        for (SymbolId id = 0; id < n; id++) {
+            if (fastGen.below(SIM_DRIFT_CHANGE_ODDS) == 0) drift[id] = fastDrift();
+        }
+    }
+
+public:
+    GbmSimulator(size_t symbols, uint32_t seed, FeedGenerator mode = FeedGenerator::Classic)
+        : generator(mode), gen(seed), fastGen(seed), prices(symbols), volatility(symbols), drift(symbols) {
+        for (SymbolId id = 0; id < symbols; id++) {
+            prices[id] = 100.0 + (gen() % 400);
+            volatility[id] = 0.3 + (gen() % 15) / 10.0; // Reduced volatility
+            drift[id] = randomDrift();
+        }
+        if (generator == FeedGenerator::Fast) {
+            noise.resize(symbols);
+            bids.resize(symbols);
+            asks.resize(symbols);
+        }
+    }
+
+    // Advances every symbol by one step and hands each new quote to sink
+    template <typename Sink>
+    void step(int64_t timestamp, Sink&& sink) {
+        if (generator == FeedGenerator::Fast) {
+            fastStep(timestamp, sink);
+        }
+        else {
+            classicStep(timestamp, sink);
+        }
+    }
+
+    // Continues the symbol's walk from price, e.g. the last recorded one
+    void resume(SymbolId symbol, double price) {
+        if (price > 0) prices[symbol] = price;
+    }
+
+    size_t size() const { return prices.size(); }
+    FeedGenerator getGenerator() const { return generator; }
+};
+
+// Binary tick file: a TickFileHeader, the symbol names (each a length byte
+// followed by the name), zero padding to TICK_FILE_ALIGN, then fixed-size
+// TickRecords until end of file. A file cut short by a crash simply ends at
+// the last complete record.
+const char TICK_FILE_MAGIC[8] = { 'H', 'F', 'T', 'T', 'I', 'C', 'K', '1' };
+const uint32_t TICK_FILE_VERSION = 1;
+const size_t TICK_FILE_ALIGN = 64;
+
+struct TickFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t symbolCount;
+    uint32_t reserved;
+    uint64_t dataOffset;  // byte offset of the first TickRecord
+};
+
+struct TickRecord {
+    uint32_t symbol;  // index into the file's own symbol table
+    uint32_t reserved;
+    double bid;
+    double ask;
+    double last;
+    int64_t volume;
+    int64_t timestamp;
+
+    MarketData toMarketData(SymbolId id) const {
+        MarketData data;
+        data.symbol = id;
+        data.bid = bid;
+        data.ask = ask;
+        data.last = last;
+        data.volume = volume;
+        data.timestamp = timestamp;
+        return data;
+    }
+
+    static TickRecord fromMarketData(const MarketData& data) {
+        TickRecord rec;
+        rec.symbol = data.symbol;
+        rec.reserved = 0;
+        rec.bid = data.bid;
+        rec.ask = data.ask;
+        rec.last = data.last;
+        rec.volume = data.volume;
+        rec.timestamp = data.timestamp;
+        return rec;
+    }
+};
+
+static_assert(sizeof(TickFileHeader) == 32, "TickFileHeader layout is part of the file format");
+static_assert(sizeof(TickRecord) == 48, "TickRecord layout is part of the file format");
+
+// Appends published ticks to a tick file through a fixed in-memory batch,
+// so the feed thread only pays for a write() once every RECORDER_BATCH ticks.
+// After the first failed write (a full disk, say) the file ends mid-stream,
+// so later batches are counted as lost rather than appended after the gap.
+class TickRecorder {
+private:
+    static const size_t RECORDER_BATCH = 8192;
+
+    std::FILE* file;
+    std::vector<TickRecord> batch;
+    uint64_t written;
+    uint64_t lost;
+    uint64_t errors;
+
+public:
+    TickRecorder(const std::string& path, const SymbolTable& symbols)
+        : file(std::fopen(path.c_str(), "wb")), written(0), lost(0), errors(0) {
+        batch.reserve(RECORDER_BATCH);
+        if (file == nullptr) return;
+
+        std::string names;
+        for (SymbolId id = 0; id < symbols.size(); id++) {
+            const std::string& name = symbols.name(id);
+            names.push_back(static_cast<char>(std::min<size_t>(name.size(), 255)));
+            names.append(name, 0, 255);
+        }
+
+        TickFileHeader header;
+        std::memcpy(header.magic, TICK_FILE_MAGIC, sizeof(header.magic));
+        header.version = TICK_FILE_VERSION;
+        header.recordSize = sizeof(TickRecord);
+        header.symbolCount = static_cast<uint32_t>(symbols.size());
+        header.reserved = 0;
+        size_t unpadded = sizeof(header) + names.size();
+        header.dataOffset = (unpadded + TICK_FILE_ALIGN - 1) / TICK_FILE_ALIGN * TICK_FILE_ALIGN;
+        names.resize(header.dataOffset - sizeof(header), '\0');
+
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1 ||
+            std::fwrite(names.data(), 1, names.size(), file) != names.size()) {
+            errors++;
+        }
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    // Feed thread only
+    void append(const MarketData& data) {
+        batch.push_back(TickRecord::fromMarketData(data));
+        if (batch.size() == RECORDER_BATCH) flush();
+    }
+
+    void flush() {
+        if (file != nullptr && !batch.empty()) {
+            if (errors == 0 && std::fwrite(batch.data(), sizeof(TickRecord), batch.size(), file) == batch.size()
+                && std::fflush(file) == 0) {
+                written += batch.size();
+            }
+            else {
+                errors++;
+                lost += batch.size();
+            }
+        }
+        batch.clear();
+    }
+
+    // Includes ticks still in the batch, so report after flush()
+    uint64_t recordsWritten() const { return written + batch.size(); }
+    uint64_t recordsLost() const { return lost; }
+    uint64_t writeErrors() const { return errors; }
+
+    ~TickRecorder() {
+        flush();
+        if (file != nullptr) std::fclose(file);
+    }
+};
+
+void printRecorderStats(const TickRecorder& recorder, const std::string& path) {
+    if (recorder.writeErrors() == 0) {
+        std::cout << Color::CYAN << "[STATS] Ticks recorded: " << recorder.recordsWritten() << " to " << path
+            << "\n" << Color::RESET;
+        return;
+    }
+    std::cout << Color::RED << "[STATS] Ticks recorded: " << recorder.recordsWritten() << " to " << path
+        << " | write errors: " << recorder.writeErrors() << " (" << recorder.recordsLost()
+        << " ticks lost, recording truncated)\n" << Color::RESET;
+}
+
+// Read-only memory mapping of a tick file. Records are consumed in place
+// straight from the page cache; nothing is parsed or copied up front.
+class TickFile {
+private:
+    const char* base;
+    size_t length;
+    const TickRecord* records;
+    size_t recordCount;
+    std::vector<std::string> names;
+    std::string error;
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mapping;
+#endif
+
+    void unmap() {
+#ifdef _WIN32
+        if (base != nullptr) UnmapViewOfFile(base);
+        if (mapping != nullptr) CloseHandle(mapping);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mapping = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (base != nullptr) munmap(const_cast<char*>(base), length);
+#endif
+        base = nullptr;
+        length = 0;
+    }
+
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) return false;
+        mapping = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) return false;
+        base = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        length = static_cast<size_t>(size.QuadPart);
+        return base != nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) return false;
+        madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        base = static_cast<const char*>(addr);
+        length = static_cast<size_t>(st.st_size);
+        return true;
+#endif
+    }
+
+public:
+    explicit TickFile(const std::string& path) : base(nullptr), length(0), records(nullptr), recordCount(0)
+#ifdef _WIN32
+        , fileHandle(INVALID_HANDLE_VALUE), mapping(nullptr)
+#endif
+    {
+        if (!map(path)) {
+            error = "cannot map " + path;
+            unmap();
+            return;
+        }
+
+        TickFileHeader header;
+        if (length < sizeof(header)) {
+            error = "truncated header";
+            unmap();
+            return;
+        }
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, TICK_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != TICK_FILE_VERSION || header.recordSize != sizeof(TickRecord) ||
+            header.dataOffset > length || header.dataOffset % TICK_FILE_ALIGN != 0) {
+            error = "not a version 1 tick file";
+            unmap();
+            return;
+        }
+
+        size_t pos = sizeof(header);
+        for (uint32_t i = 0; i < header.symbolCount; i++) {
+            if (pos >= header.dataOffset) {
+                error = "corrupt symbol table";
+                unmap();
+                return;
+            }
+            size_t len = static_cast<unsigned char>(base[pos++]);
+            if (pos + len > header.dataOffset) {
+                error = "corrupt symbol table";
+                unmap();
+                return;
+            }
+            names.push_back(std::string(base + pos, len));
+            pos += len;
+        }
+
+        records = reinterpret_cast<const TickRecord*>(base + header.dataOffset);
+        recordCount = (length - header.dataOffset) / sizeof(TickRecord);
+    }
+
+    bool isOpen() const { return base != nullptr; }
+    const std::string& getError() const { return error; }
+
+    const TickRecord* begin() const { return records; }
+    const TickRecord* end() const { return records + recordCount; }
+    size_t size() const { return recordCount; }
+    const std::vector<std::string>& symbolNames() const { return names; }
+
+    // Maps each file symbol index to the caller's SymbolId (INVALID_SYMBOL if absent)
+    std::vector<SymbolId> mapSymbols(const SymbolTable& symbols) const {
+        std::vector<SymbolId> ids(names.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            ids[i] = symbols.find(names[i]);
+        }
+        return ids;
+    }
+
+    TickFile(const TickFile&) = delete;
+    TickFile& operator=(const TickFile&) = delete;
+    ~TickFile() { unmap(); }
+};
+
+const double BOOK_TICK_SIZE = 0.01;
+const int64_t BOOK_RANGE_TICKS = 1024;     // price levels tracked per side
+const size_t BOOK_SNAPSHOT_LEVELS = 16;    // depth per side republished for readers
+const size_t DEFAULT_BOOK_LEVELS = 10;     // synthetic depth per side
+const int64_t SIM_BOOK_TOUCH_DIVISOR = 10000; // synthetic touch size is volume / this
+const uint32_t NO_ORDER = std::numeric_limits<uint32_t>::max();
+
+enum BookSide { BOOK_BID, BOOK_ASK };
+
+inline int64_t toBookTicks(double price) { return std::llround(price / BOOK_TICK_SIZE); }
+inline double fromBookTicks(int64_t ticks) { return ticks * BOOK_TICK_SIZE; }
+
+// An L3 order resting in a BookStore; orders at one level form a FIFO queue
+struct RestingOrder {
+    uint64_t id;
+    int64_t price;     // ticks
+    int64_t quantity;
+    SymbolId symbol;
+    uint32_t prev;     // neighbours in the level's queue, NO_ORDER at either end
+    uint32_t next;
+    BookSide side;
+    bool queued;       // false while its price is outside the ladder's window
+};
+
+// One side of one symbol's book. Aggregate quantity, order count and the L3
+// queue ends are flat arrays indexed by tick offset from base, so add,
+// modify and cancel each touch one slot. The best level is cached; it is
+// only rescanned when the best level empties, walking to the next occupied
+// one. A price outside the window recentres it: on that price if it is
+// better than the best, dropping whatever falls off the far end, or
+// between the two if it is worse but within one window of the best. Worse
+// prices further out than that are not tracked.
+class BookLadder {
+private:
+    bool higherIsBetter;
+    int64_t base;  // price in ticks of slot 0
+    std::vector<int64_t> quantity;
+    std::vector<uint32_t> orders;
+    std::vector<uint32_t> head;
+    std::vector<uint32_t> tail;
+    int64_t best;  // slot of the best level, -1 when the side is empty
+    int64_t occupied;  // levels with quantity, so emptying the side needs no scan
+    uint64_t dropped;
+
+    bool better(int64_t a, int64_t b) const { return higherIsBetter ? a > b : a < b; }
+
+    // Best occupied slot at or behind from
+    void rescan(int64_t from) {
+        if (occupied == 0) {
+            best = -1;
+            return;
+        }
+        int64_t step = higherIsBetter ? -1 : 1;
+        for (int64_t s = from; s >= 0 && s < BOOK_RANGE_TICKS; s += step) {
+            if (quantity[s] > 0) {
+                best = s;
+                return;
+            }
+        }
+        best = -1;
+    }
+
+    void recenter(int64_t newBase, std::vector<RestingOrder>& pool) {
+        int64_t shift = newBase - base;
+        for (int64_t s = 0; s < BOOK_RANGE_TICKS; s++) {
+            int64_t moved = s - shift;
+            if (moved >= 0 && moved < BOOK_RANGE_TICKS) continue;
+            if (quantity[s] > 0) {
+                dropped++;
+                occupied--;
+            }
+            for (uint32_t o = head[s]; o != NO_ORDER; o = pool[o].next) pool[o].queued = false;
+        }
+        auto slide = [shift](auto& v, auto empty) {
+            if (shift > 0) {
+                int64_t keep = std::max<int64_t>(0, BOOK_RANGE_TICKS - shift);
+                std::copy(v.begin() + (BOOK_RANGE_TICKS - keep), v.end(), v.begin());
+                std::fill(v.begin() + keep, v.end(), empty);
+            }
+            else {
+                int64_t keep = std::max<int64_t>(0, BOOK_RANGE_TICKS + shift);
+                std::copy_backward(v.begin(), v.begin() + keep, v.end());
+                std::fill(v.begin(), v.end() - keep, empty);
+            }
+        };
+        slide(quantity, int64_t(0));
+        slide(orders, uint32_t(0));
+        slide(head, NO_ORDER);
+        slide(tail, NO_ORDER);
+        base += shift;
+        rescan(higherIsBetter ? BOOK_RANGE_TICKS - 1 : 0);
+    }
+
+    // -1 for a price too far behind the best to keep
+    int64_t slotFor(int64_t price, std::vector<RestingOrder>& pool) {
+        int64_t s = slotOf(price);
+        if (s >= 0) return s;
+        if (best < 0) {
+            base = price - BOOK_RANGE_TICKS / 2;
+        }
+        else if (better(price - base, best)) {
+            recenter(price - BOOK_RANGE_TICKS / 2, pool);
+        }
+        else if (std::abs(price - bestPrice()) < BOOK_RANGE_TICKS - 1) {
+            // The truncated midpoint can sit a tick off centre, so a price
+            // needs one tick of margin to fit beside the best after the slide
+            recenter((price + bestPrice()) / 2 - BOOK_RANGE_TICKS / 2, pool);
+        }
+        else {
+            dropped++;
+            return -1;
+        }
+        s = slotOf(price);
+        if (s < 0) dropped++;
+        return s;
+    }
+
+    // Called after every change to slot s; wasOccupied is its state before
+    void settle(int64_t s, bool wasOccupied) {
+        if (quantity[s] <= 0) {
+            quantity[s] = 0;
+            orders[s] = 0;
+            if (wasOccupied) occupied--;
+            if (s == best) rescan(s);
+        }
+        else {
+            if (!wasOccupied) occupied++;
+            if (best < 0 || better(s, best)) best = s;
+        }
+    }
+
+public:
+    explicit BookLadder(bool bids) : higherIsBetter(bids), base(0), quantity(BOOK_RANGE_TICKS, 0),
+        orders(BOOK_RANGE_TICKS, 0), head(BOOK_RANGE_TICKS, NO_ORDER), tail(BOOK_RANGE_TICKS, NO_ORDER),
+        best(-1), occupied(0), dropped(0) {
+    }
+
+    int64_t slotOf(int64_t price) const {
+        int64_t s = price - base;
+        return s >= 0 && s < BOOK_RANGE_TICKS ? s : -1;
+    }
+
+    // L2: replaces the aggregate quantity resting at price
+    void set(int64_t price, int64_t qty, std::vector<RestingOrder>& pool) {
+        if (qty <= 0 && slotOf(price) < 0) return;
+        int64_t s = slotFor(price, pool);
+        if (s < 0) return;
+        bool was = quantity[s] > 0;
+        quantity[s] = qty;
+        orders[s] = qty > 0 ? std::max<uint32_t>(orders[s], 1) : 0;
+        settle(s, was);
+    }
+
+    // L3: appends an order to the back of its level's queue
+    void enqueue(uint32_t slot, std::vector<RestingOrder>& pool) {
+        RestingOrder& order = pool[slot];
+        int64_t s = slotFor(order.price, pool);
+        order.queued = false;
+        if (s < 0) return;
+        order.prev = tail[s];
+        order.next = NO_ORDER;
+        order.queued = true;
+        if (tail[s] != NO_ORDER) pool[tail[s]].next = slot;
+        else head[s] = slot;
+        tail[s] = slot;
+        bool was = quantity[s] > 0;
+        quantity[s] += order.quantity;
+        orders[s]++;
+        settle(s, was);
+    }
+
+    // L3: takes qty shares off a queued order without losing its place
+    void reduce(const RestingOrder& order, int64_t qty) {
+        int64_t s = order.queued ? slotOf(order.price) : -1;
+        if (s < 0) return;
+        quantity[s] -= qty;
+        settle(s, true);
+    }
+
+    // L3: removes what remains of an order and closes the gap in its queue
+    void unlink(uint32_t slot, std::vector<RestingOrder>& pool) {
+        RestingOrder& order = pool[slot];
+        int64_t s = order.queued ? slotOf(order.price) : -1;
+        if (order.queued) {
+            if (order.prev != NO_ORDER) pool[order.prev].next = order.next;
+            else if (s >= 0) head[s] = order.next;
+            if (order.next != NO_ORDER) pool[order.next].prev = order.prev;
+            else if (s >= 0) tail[s] = order.prev;
+        }
+        order.queued = false;
+        if (s < 0) return;
+        quantity[s] -= order.quantity;
+        if (orders[s] > 0) orders[s]--;
+        settle(s, true);
+    }
+
+    bool empty() const { return best < 0; }
+    int64_t bestPrice() const { return base + best; }
+    int64_t bestQuantity() const { return best >= 0 ? quantity[best] : 0; }
+
+    // Copies up to n occupied levels, best first; returns how many
+    size_t top(size_t n, int64_t* prices, int64_t* quantities) const {
+        if (best < 0) return 0;
+        int64_t step = higherIsBetter ? -1 : 1;
+        size_t count = 0;
+        n = std::min(n, static_cast<size_t>(occupied));
+        for (int64_t s = best; count < n && s >= 0 && s < BOOK_RANGE_TICKS; s += step) {
+            if (quantity[s] == 0) continue;
+            prices[count] = base + s;
+            quantities[count] = quantity[s];
+            count++;
+        }
+        return count;
+    }
+
+    uint64_t getDropped() const { return dropped; }
+};
+
+// A reader's copy of the top of one symbol's book
+struct BookDepth {
+    uint32_t levels[2];  // by BookSide
+    double price[2][BOOK_SNAPSHOT_LEVELS];
+    int64_t quantity[2][BOOK_SNAPSHOT_LEVELS];
+
+    // Walks the levels a market order of qty would take from side; returns
+    // the shares available, their average price and the levels touched
+    int64_t sweep(BookSide side, int64_t qty, double& avgPrice, size_t& levelsUsed) const {
+        int64_t filled = 0;
+        double notional = 0.0;
+        levelsUsed = 0;
+        for (uint32_t k = 0; k < levels[side] && filled < qty; k++) {
+            int64_t take = std::min(qty - filled, quantity[side][k]);
+            notional += take * price[side][k];
+            filled += take;
+            levelsUsed++;
+        }
+        avgPrice = filled > 0 ? notional / filled : 0.0;
+        return filled;
+    }
+};
+
+// The ladder the simulator lays around a quote: the touch rounded out to
+// whole ticks, the touch size taken from the quote volume, and level k
+// deeper on each side holding k + 1 times the touch
+inline int64_t syntheticTouchSize(const MarketData& data) {
+    return std::max<int64_t>(1, data.volume / SIM_BOOK_TOUCH_DIVISOR);
+}
+
+inline void syntheticTouchTicks(const MarketData& data, int64_t& bid, int64_t& ask) {
+    bid = static_cast<int64_t>(std::floor(data.bid / BOOK_TICK_SIZE + 1e-9));
+    ask = std::max(bid + 1, static_cast<int64_t>(std::ceil(data.ask / BOOK_TICK_SIZE - 1e-9)));
+}
+
+// The same ladder without a BookStore, for venues simulated on bare quotes
+inline void syntheticDepth(const MarketData& data, size_t levels, BookDepth& depth) {
+    int64_t bid, ask;
+    syntheticTouchTicks(data, bid, ask);
+    int64_t touch = syntheticTouchSize(data);
+    levels = std::min<size_t>(levels, BOOK_SNAPSHOT_LEVELS);
+    for (size_t k = 0; k < levels; k++) {
+        int64_t offset = static_cast<int64_t>(k);
+        depth.price[BOOK_BID][k] = fromBookTicks(bid - offset);
+        depth.price[BOOK_ASK][k] = fromBookTicks(ask + offset);
+        depth.quantity[BOOK_BID][k] = touch * (offset + 1);
+        depth.quantity[BOOK_ASK][k] = touch * (offset + 1);
+    }
+    depth.levels[BOOK_BID] = depth.levels[BOOK_ASK] = static_cast<uint32_t>(levels);
+}
+
+// Per-symbol L2/L3 books. The feed thread is the only writer: the simulator
+// synthesizes depth around each quote, and an L3 feed adds, reduces and
+// deletes individual orders. After each update the top BOOK_SNAPSHOT_LEVELS
+// levels per side are republished under a seqlock, like QuoteStore, so the
+// engine can walk them from any thread. Order ids are global to the store
+// because feeds reference an order by id alone once it rests.
+class BookStore {
+private:
+    struct SymbolBook {
+        BookLadder bids;
+        BookLadder asks;
+        bool fromOrders;     // an L3 feed owns this book; quotes no longer synthesize it
+        int64_t synthBid;    // where the last synthetic depth was laid, in ticks
+        int64_t synthAsk;
+        size_t synthLevels;
+
+        SymbolBook() : bids(true), asks(false), fromOrders(false), synthBid(0), synthAsk(0), synthLevels(0) {}
+
+        BookLadder& side(BookSide s) { return s == BOOK_BID ? bids : asks; }
+        const BookLadder& side(BookSide s) const { return s == BOOK_BID ? bids : asks; }
+    };
+
+    std::vector<SymbolBook> books;
+    std::vector<RestingOrder> pool;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<uint64_t, uint32_t> index;  // order id -> pool slot
+
+    std::vector<std::atomic<uint32_t>> seq;
+    std::vector<std::atomic<uint32_t>> levelCount;  // [symbol][side]
+    std::vector<std::atomic<int64_t>> levelPrice;   // [symbol][side][level], ticks
+    std::vector<std::atomic<int64_t>> levelQty;
+
+    void republish(SymbolId id) {
+        int64_t prices[BOOK_SNAPSHOT_LEVELS];
+        int64_t quantities[BOOK_SNAPSHOT_LEVELS];
+        uint32_t version = seq[id].load(std::memory_order_relaxed);
+        seq[id].store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (int s = BOOK_BID; s <= BOOK_ASK; s++) {
+            size_t n = books[id].side(static_cast<BookSide>(s)).top(BOOK_SNAPSHOT_LEVELS, prices, quantities);
+            size_t at = (id * 2 + s) * BOOK_SNAPSHOT_LEVELS;
+            for (size_t k = 0; k < n; k++) {
+                levelPrice[at + k].store(prices[k], std::memory_order_relaxed);
+                levelQty[at + k].store(quantities[k], std::memory_order_relaxed);
+            }
+            levelCount[id * 2 + s].store(static_cast<uint32_t>(n), std::memory_order_relaxed);
+        }
+
+        seq[id].store(version + 2, std::memory_order_release);
+    }
+
+    void topOf(SymbolId id, int64_t& bid, int64_t& ask) const {
+        const SymbolBook& book = books[id];
+        bid = book.bids.empty() ? 0 : book.bids.bestPrice();
+        ask = book.asks.empty() ? 0 : book.asks.bestPrice();
+    }
+
+    template <typename Update>
+    bool changeTop(SymbolId id, Update&& update) {
+        int64_t bidBefore, askBefore, bidAfter, askAfter;
+        topOf(id, bidBefore, askBefore);
+        update();
+        republish(id);
+        topOf(id, bidAfter, askAfter);
+        return bidBefore != bidAfter || askBefore != askAfter;
+    }
+
+    // Takes qty off a resting order, deleting it once nothing is left. A
+    // partial take of nothing or less is refused: it would grow the order.
+    bool take(uint64_t orderId, int64_t qty, bool all) {
+        if (!all && qty <= 0) return false;
+        auto it = index.find(orderId);
+        if (it == index.end()) return false;
+        uint32_t slot = it->second;
+        RestingOrder& order = pool[slot];
+        SymbolBook& book = books[order.symbol];
+        return changeTop(order.symbol, [&]() {
+            BookLadder& ladder = book.side(order.side);
+            if (all || qty >= order.quantity) {
+                ladder.unlink(slot, pool);
+                index.erase(it);
+                freeSlots.push_back(slot);
+            }
+            else {
+                ladder.reduce(order, qty);
+                order.quantity -= qty;
+            }
+        });
+    }
+
+public:
+    explicit BookStore(size_t symbols) : books(symbols), seq(symbols), levelCount(symbols * 2),
+        levelPrice(symbols * 2 * BOOK_SNAPSHOT_LEVELS), levelQty(symbols * 2 * BOOK_SNAPSHOT_LEVELS) {
+        for (size_t i = 0; i < seq.size(); i++) seq[i].store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < levelCount.size(); i++) levelCount[i].store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < levelPrice.size(); i++) {
+            levelPrice[i].store(0, std::memory_order_relaxed);
+            levelQty[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Writer side from here to the readers; feed thread only.
+
+    // Lays `levels` levels per side, one tick apart, outward from the
+    // quote's touch, deepening linearly away from it. Symbols an L3 feed
+    // has taken over are left alone.
+    void synthesize(const MarketData& data, size_t levels) {
+        SymbolBook& book = books[data.symbol];
+        if (book.fromOrders || data.bid <= 0 || data.ask <= 0) return;
+        for (size_t k = 0; k < book.synthLevels; k++) {
+            book.bids.set(book.synthBid - static_cast<int64_t>(k), 0, pool);
+            book.asks.set(book.synthAsk + static_cast<int64_t>(k), 0, pool);
+        }
+        int64_t bid, ask;
+        syntheticTouchTicks(data, bid, ask);
+        int64_t touch = syntheticTouchSize(data);
+        for (size_t k = 0; k < levels; k++) {
+            int64_t qty = touch * static_cast<int64_t>(k + 1);
+            book.bids.set(bid - static_cast<int64_t>(k), qty, pool);
+            book.asks.set(ask + static_cast<int64_t>(k), qty, pool);
+        }
+        book.synthBid = bid;
+        book.synthAsk = ask;
+        book.synthLevels = levels;
+        republish(data.symbol);
+    }
+
+    // The O(1) L3 updates below return whether the best bid or ask moved.
+    // Each new id grows the id index, so an L3 feed allocates per add.
+    bool addOrder(uint64_t orderId, SymbolId symbol, BookSide side, double price, int64_t qty) {
+        if (qty <= 0 || index.count(orderId) != 0) return false;
+        SymbolBook& book = books[symbol];
+        if (!book.fromOrders) {
+            // First order for the symbol: the synthetic depth gives way
+            for (size_t k = 0; k < book.synthLevels; k++) {
+                book.bids.set(book.synthBid - static_cast<int64_t>(k), 0, pool);
+                book.asks.set(book.synthAsk + static_cast<int64_t>(k), 0, pool);
+            }
+            book.synthLevels = 0;
+            book.fromOrders = true;
+        }
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            slot = static_cast<uint32_t>(pool.size());
+            pool.emplace_back();
+        }
+        RestingOrder& order = pool[slot];
+        order.id = orderId;
+        order.price = toBookTicks(price);
+        order.quantity = qty;
+        order.symbol = symbol;
+        order.side = side;
+        index.emplace(orderId, slot);
+        return changeTop(symbol, [&]() { book.side(side).enqueue(slot, pool); });
+    }
+
+    // An execution or partial cancel; the order keeps its queue position
+    bool reduceOrder(uint64_t orderId, int64_t qty) { return take(orderId, qty, false); }
+    bool deleteOrder(uint64_t orderId) { return take(orderId, 0, true); }
+
+    bool hasOrder(uint64_t orderId) const { return index.count(orderId) != 0; }
+
+    SymbolId orderSymbol(uint64_t orderId) const {
+        auto it = index.find(orderId);
+        return it == index.end() ? INVALID_SYMBOL : pool[it->second].symbol;
+    }
+
+    // Shares queued ahead of an order at its price; -1 for an unknown id
+    int64_t queueAhead(uint64_t orderId) const {
+        auto it = index.find(orderId);
+        if (it == index.end()) return -1;
+        int64_t ahead = 0;
+        for (uint32_t o = pool[it->second].prev; o != NO_ORDER; o = pool[o].prev) ahead += pool[o].quantity;
+        return ahead;
+    }
+
+    // Best bid and ask as this thread last wrote them; false while a side is empty
+    bool bestPrices(SymbolId id, double& bid, double& ask) const {
+        const SymbolBook& book = books[id];
+        if (book.bids.empty() || book.asks.empty()) return false;
+        bid = fromBookTicks(book.bids.bestPrice());
+        ask = fromBookTicks(book.asks.bestPrice());
+        return true;
+    }
+
+    size_t restingOrders() const { return index.size(); }
+
+    uint64_t levelsDropped() const {
+        uint64_t total = 0;
+        for (const SymbolBook& book : books) total += book.bids.getDropped() + book.asks.getDropped();
+        return total;
+    }
+
+    // Readers; lock-free, any thread. Returns seqlock retries.
+    uint32_t read(SymbolId id, BookDepth& depth) const {
+        uint32_t retries = 0;
+        while (true) {
+            uint32_t before = seq[id].load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                for (int s = BOOK_BID; s <= BOOK_ASK; s++) {
+                    uint32_t n = std::min<uint32_t>(levelCount[id * 2 + s].load(std::memory_order_relaxed),
+                        static_cast<uint32_t>(BOOK_SNAPSHOT_LEVELS));
+                    size_t at = (id * 2 + s) * BOOK_SNAPSHOT_LEVELS;
+                    for (uint32_t k = 0; k < n; k++) {
+                        depth.price[s][k] = fromBookTicks(levelPrice[at + k].load(std::memory_order_relaxed));
+                        depth.quantity[s][k] = levelQty[at + k].load(std::memory_order_relaxed);
+                    }
+                    depth.levels[s] = n;
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq[id].load(std::memory_order_relaxed) == before) return retries;
+            }
+            retries++;
+        }
+    }
+
+    size_t size() const { return books.size(); }
+};
+
+// Counters kept by a feed handler's thread; read once it has stopped
+struct FeedStats {
+    uint64_t packets;
+    uint64_t messages;
+    uint64_t quotes;
+    uint64_t gaps;          // times the sequence jumped forward
+    uint64_t missed;        // messages lost in those jumps
+    uint64_t duplicates;    // messages at or below the last sequence seen
+    uint64_t malformed;     // packets or frames that failed to parse; L3 adds and reduces with no
+                            // quantity, and adds for an id already resting
+    uint64_t unknownSymbols;
+    uint64_t orders;        // L3 add, reduce and delete messages applied to the books
+    uint64_t unknownOrders; // reduces and deletes for ids not resting
+
+    FeedStats() : packets(0), messages(0), quotes(0), gaps(0), missed(0), duplicates(0),
+        malformed(0), unknownSymbols(0), orders(0), unknownOrders(0) {
+    }
+};
+
+class MarketDataProvider;
+
+// A live market data source. The provider's feed thread calls poll() in a
+// loop; it decodes whatever has arrived straight into the provider and may
+// block for at most FEED_POLL_TIMEOUT_MS so that stop() is noticed.
+class FeedHandler {
+public:
+    virtual size_t poll(MarketDataProvider& provider) = 0;
+    virtual const FeedStats& getStats() const = 0;
+    virtual std::string describe() const = 0;
+    virtual ~FeedHandler() {}
+};
+
+class MarketDataProvider {
+private:
+    const SymbolTable& symbols;
+    QuoteStore latestData;
+    HistoryStore priceHistory;
+    IndicatorCache indicators;
+    std::vector<TickChannel*> routes; // consumer for each SymbolId, or null
+    std::atomic<bool> running;
+    std::thread dataThread;
+    GbmSimulator simulator;
+    std::atomic<uint64_t> quoteRetries;
+    TickRecorder* recorder;
+    const TickFile* replaySource;
+    double replaySpeed;
+    FeedHandler* feed;
+    std::unique_ptr<BookStore> books;
+    size_t bookLevels;
+    int64_t tickInterval;
+    std::atomic<uint64_t> published;
+
+    void receiveData() {
+        while (running) feed->poll(*this);
+    }
+
+    void simulateData() {
+        while (running) {
+            simulator.step(wallClockNanos(), [this](const MarketData& data) { publish(data); });
+            if (tickInterval > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(tickInterval));
+        }
+    }
+
+    // Streams the mapped file through publish(), pacing by the recorded
+    // timestamps divided by replaySpeed (0 replays as fast as possible)
+    void replayData() {
+        std::vector<SymbolId> ids = replaySource->mapSymbols(symbols);
+        const TickRecord* first = replaySource->begin();
+        int64_t startNanos = monotonicNanos();
+
+        for (const TickRecord* rec = first; rec != replaySource->end() && running; ++rec) {
+            if (rec->symbol >= ids.size() || ids[rec->symbol] == INVALID_SYMBOL) continue;
+
+            if (replaySpeed > 0) {
+                int64_t due = startNanos + static_cast<int64_t>((rec->timestamp - first->timestamp) / replaySpeed);
+                int64_t wait = due - monotonicNanos();
+                if (wait > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+            }
+            publish(rec->toMarketData(ids[rec->symbol]));
+        }
+    }
+
+public:
+    MarketDataProvider(const SymbolTable& syms, uint32_t seed,
+        size_t historyWindow = DEFAULT_HISTORY_WINDOW, FeedGenerator generator = FeedGenerator::Classic)
+        : symbols(syms), latestData(syms.size()), priceHistory(syms.size(), historyWindow),
+        indicators(syms.size()), routes(syms.size(), nullptr),
+        running(false), simulator(syms.size(), seed, generator), quoteRetries(0),
+        recorder(nullptr), replaySource(nullptr), replaySpeed(1.0), feed(nullptr), bookLevels(0),
+        tickInterval(TICK_INTERVAL_NANOS), published(0) {
+    }
+
+    // Must be called before start(); 0 runs the simulated feed flat out
+    void setTickInterval(int64_t nanos) { tickInterval = std::max<int64_t>(0, nanos); }
+
+    // Must be called before start(); every published tick is also recorded
+    void setRecorder(TickRecorder* rec) { recorder = rec; }
+
+    // Must be called before start(); the feed replays the file instead of simulating
+    void setReplay(const TickFile* source, double speed) {
+        replaySource = source;
+        replaySpeed = speed;
+    }
+
+    // Must be called before start(); quotes come from the handler instead of the simulator
+    void setFeed(FeedHandler* handler) { feed = handler; }
+
+    // Must be called before start(); keeps a book per symbol, with `levels`
+    // synthetic levels per side laid around each quote (0 leaves the books
+    // to an L3 feed)
+    void enableBooks(size_t levels) {
+        books = std::make_unique<BookStore>(symbols.size());
+        bookLevels = std::min(levels, BOOK_SNAPSHOT_LEVELS);
+    }
+
+    // Null unless enableBooks() was called; readers use BookStore::read()
+    BookStore* getBooks() { return books.get(); }
+    const BookStore* getBooks() const { return books.get(); }
+
+    // Quote, history, indicators and synthetic book; no recording or routing
+    void apply(const MarketData& data) {
+        HFT_PROFILE_SCOPE(PROFILE_HISTORY);
+        SymbolId id = data.symbol;
+        latestData.set(data);
+        priceHistory.push(id, data.last);
+        indicators.update(id, data.last);
+        if (books && bookLevels > 0) books->synthesize(data, bookLevels);
+    }
+
+    // Before start(): loads the newest history window of every symbol in the
+    // file into quotes, history and indicators, so the strategies can decide
+    // on the first live tick. The simulator carries on from each symbol's
+    // last recorded price. Returns the ticks applied; `ready` receives the
+    // symbols that now have MIN_DECISION_HISTORY prices.
+    size_t warmStart(const TickFile& file, size_t& ready) {
+        std::vector<SymbolId> ids = file.mapSymbols(symbols);
+        std::vector<size_t> seen(symbols.size(), 0);
+        size_t window = priceHistory.windowLength();
+        size_t full = 0;
+        const TickRecord* from = file.end();
+        while (from != file.begin() && full < symbols.size()) {
+            const TickRecord* rec = from - 1;
+            if (rec->symbol < ids.size() && ids[rec->symbol] != INVALID_SYMBOL && ++seen[ids[rec->symbol]] == window) {
+                full++;
+            }
+            from = rec;
+        }
+        size_t applied = 0;
+        for (const TickRecord* rec = from; rec != file.end(); ++rec) {
+            if (rec->symbol >= ids.size() || ids[rec->symbol] == INVALID_SYMBOL) continue;
+            apply(rec->toMarketData(ids[rec->symbol]));
+            simulator.resume(ids[rec->symbol], rec->last);
+            applied++;
+        }
+        ready = 0;
+        for (SymbolId id = 0; id < symbols.size(); id++) {
+            if (priceHistory.view(id).size() >= MIN_DECISION_HISTORY) ready++;
+        }
+        return applied;
+    }
+
+    // Writer side: updates quote, history and indicators, then notifies the
+    // symbol's consumer. Only one thread may publish (the feed, or a backtest).
+    void publish(const MarketData& data) {
+        SymbolId id = data.symbol;
+        apply(data);
+        if (recorder != nullptr) recorder->append(data);
+        published.store(published.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (routes[id] != nullptr) {
+            TickEvent event;
+            event.symbol = id;
+            event.publishCycles = cycleCounter();
+            routes[id]->publish(event);
+        }
+    }
+
+    GbmSimulator& getSimulator() { return simulator; }
+    uint64_t getPublished() const { return published.load(std::memory_order_relaxed); }
+    std::thread& getFeedThread() { return dataThread; }
+
+    // Must be called before start(); ticks for the symbol are pushed to the channel
+    void route(SymbolId symbol, TickChannel* channel) {
+        routes[symbol] = channel;
+    }
+
+    void start() {
+        running = true;
+        if (feed != nullptr) {
+            dataThread = std::thread(&MarketDataProvider::receiveData, this);
+        }
+        else if (replaySource != nullptr) {
+            dataThread = std::thread(&MarketDataProvider::replayData, this);
+        }
+        else {
+            dataThread = std::thread(&MarketDataProvider::simulateData, this);
+        }
+    }
+
+    // Lock-free; never blocks the feed thread
+    MarketData getData(SymbolId symbol) {
+        MarketData data;
+        uint32_t retries = latestData.get(symbol, data);
+        if (retries > 0) {
+            quoteRetries.fetch_add(retries, std::memory_order_relaxed);
+        }
+        return data;
+    }
+
+    // Zero-copy view of up to historyWindow most recent prices, oldest first
+    PriceWindow getHistory(SymbolId symbol) const {
+        return priceHistory.view(symbol);
+    }
+
+    bool historyIntact(SymbolId symbol, const PriceWindow& history) const {
+        return priceHistory.intact(symbol, history);
+    }
+
+    Indicators getIndicators(SymbolId symbol) {
+        Indicators ind;
+        uint32_t retries = indicators.get(symbol, ind);
+        if (retries > 0) {
+            quoteRetries.fetch_add(retries, std::memory_order_relaxed);
+        }
+        return ind;
+    }
+
+    // Gathers every symbol into the batch kernels' input
+    void snapshot(UniverseFrame& frame) {
+        for (SymbolId id = 0; id < frame.count; id++) {
+            PriceWindow history = getHistory(id);
+            frame.set(id, getData(id), history, getIndicators(id));
+            assert(historyIntact(id, history) && "feed lapped a history view");
+        }
+    }
+
+    size_t getHistoryWindow() const { return priceHistory.windowLength(); }
+
+    ContentionStats getContentionStats() const {
+        ContentionStats stats;
+        stats.quoteRetries = quoteRetries.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // Stops and joins the feed thread; quotes, history and indicators stay readable
+    void stop() {
+        running = false;
+        if (dataThread.joinable()) dataThread.join();
+    }
+
+    ~MarketDataProvider() {
+        stop();
+    }
+};
+
+// Binary feed protocol, MoldUDP64-style framing around ITCH-style messages.
+// A packet is a FeedPacketHeader followed by `count` messages, each starting
+// with its own length and type so unknown types can be skipped. Every
+// message consumes one sequence number; a packet with no messages is a
+// heartbeat. Fields are little-endian with natural alignment, and prices
+// are fixed point in units of 1 / FEED_PRICE_SCALE.
+// Over TCP each packet is prefixed with its uint16 length.
+const uint32_t FEED_SESSION_MAGIC = 0x46544648;  // "HFTF"
+const uint16_t FEED_PROTOCOL_VERSION = 1;
+const double FEED_PRICE_SCALE = 1e8;
+const size_t FEED_MAX_PACKET = 1472;             // one unfragmented Ethernet UDP payload
+const size_t FEED_SYMBOL_CHARS = 16;
+const int FEED_POLL_TIMEOUT_MS = 100;
+
+struct FeedPacketHeader {
+    uint64_t sequence;  // of the first message in the packet
+    uint16_t count;
+    uint16_t version;
+    uint32_t session;
+};
+
+struct FeedMessageHeader {
+    uint16_t length;  // whole message, header included
+    char type;
+    uint8_t reserved;
+};
+
+// 'R': binds a wire instrument id to a symbol name for the rest of the session
+struct FeedDirectoryMessage {
+    FeedMessageHeader header;
+    uint32_t instrument;
+    char symbol[FEED_SYMBOL_CHARS];  // NUL-padded
+};
+
+// 'Q': top of book and last trade
+struct FeedQuoteMessage {
+    FeedMessageHeader header;
+    uint32_t instrument;
+    int64_t timestamp;  // exchange time, nanoseconds since the epoch
+    int64_t bid;
+    int64_t ask;
+    int64_t last;
+    int64_t volume;
+};
+
+// 'A': a new order resting at the back of its price level
+struct FeedAddOrderMessage {
+    FeedMessageHeader header;
+    uint32_t instrument;
+    uint64_t order;
+    int64_t timestamp;
+    int64_t price;
+    int64_t quantity;
+    char side;        // 'B' or 'S'
+    uint8_t reserved[7];
+};
+
+// 'X': shares executed or cancelled from a resting order; 'D': the rest of it
+// is gone. Neither repeats the instrument: the order id identifies it.
+struct FeedOrderUpdateMessage {
+    FeedMessageHeader header;
+    uint32_t reserved;
+    uint64_t order;
+    int64_t timestamp;
+    int64_t quantity;  // ignored for 'D'
+};
+
+static_assert(sizeof(FeedPacketHeader) == 16, "FeedPacketHeader layout is part of the wire format");
+static_assert(sizeof(FeedDirectoryMessage) == 24, "FeedDirectoryMessage layout is part of the wire format");
+static_assert(sizeof(FeedQuoteMessage) == 48, "FeedQuoteMessage layout is part of the wire format");
+static_assert(sizeof(FeedAddOrderMessage) == 48, "FeedAddOrderMessage layout is part of the wire format");
+static_assert(sizeof(FeedOrderUpdateMessage) == 32, "FeedOrderUpdateMessage layout is part of the wire format");
+
+inline int64_t toFeedPrice(double price) { return static_cast<int64_t>(std::llround(price * FEED_PRICE_SCALE)); }
+inline double fromFeedPrice(int64_t price) { return price / FEED_PRICE_SCALE; }
+
+// Decodes packets in place from the receive buffer into the provider. The
+// instrument map only grows when a directory message names a new id, so the
+// steady state does no allocation. Single-threaded: the feed thread only.
+class FeedDecoder {
+private:
+    const SymbolTable& symbols;
+    std::vector<SymbolId> instruments;  // wire instrument id -> SymbolId
+    uint64_t nextSequence;              // 0 until the first packet arrives
+    FeedStats stats;
+
+    void onDirectory(const uint8_t* msg) {
+        FeedDirectoryMessage dir;
+        std::memcpy(&dir, msg, sizeof(dir));
+        size_t len = 0;
+        while (len < FEED_SYMBOL_CHARS && dir.symbol[len] != '\0') len++;
+        if (dir.instrument >= MAX_UNIVERSE_SIZE * 4) {
+            stats.malformed++;
+            return;
+        }
+        if (dir.instrument >= instruments.size()) instruments.resize(dir.instrument + 1, INVALID_SYMBOL);
+        instruments[dir.instrument] = symbols.find(std::string(dir.symbol, len));
+    }
+
+    void onQuote(const uint8_t* msg, MarketDataProvider& provider);
+    void onOrder(const uint8_t* msg, char type, MarketDataProvider& provider);
+
+public:
+    explicit FeedDecoder(const SymbolTable& syms) : symbols(syms), nextSequence(0) {}
+
+    // Returns the number of quotes published from the packet
+    size_t decode(const uint8_t* packet, size_t length, MarketDataProvider& provider) {
+        HFT_PROFILE_SCOPE(PROFILE_FEED_DECODE);
+        FeedPacketHeader header;
+        if (length < sizeof(header)) {
+            stats.malformed++;
+            return 0;
+        }
+        std::memcpy(&header, packet, sizeof(header));
+        if (header.session != FEED_SESSION_MAGIC || header.version != FEED_PROTOCOL_VERSION) {
+            stats.malformed++;
+            return 0;
+        }
+        stats.packets++;
+
+        uint64_t sequence = header.sequence;
+        if (nextSequence != 0 && sequence > nextSequence) {
+            stats.gaps++;
+            stats.missed += sequence - nextSequence;
+        }
+
+        uint64_t before = stats.quotes;
+        size_t pos = sizeof(header);
+        for (uint16_t i = 0; i < header.count; i++, sequence++) {
+            FeedMessageHeader msg;
+            if (pos + sizeof(msg) > length) {
+                stats.malformed++;
+                break;
+            }
+            std::memcpy(&msg, packet + pos, sizeof(msg));
+            if (msg.length < sizeof(msg) || pos + msg.length > length) {
+                stats.malformed++;
+                break;
+            }
+            stats.messages++;
+            // A retransmitted or reordered message we have already applied
+            if (nextSequence != 0 && sequence < nextSequence) {
+                stats.duplicates++;
+            }
+            else if (msg.type == 'Q' && msg.length >= sizeof(FeedQuoteMessage)) {
+                onQuote(packet + pos, provider);
+            }
+            else if (msg.type == 'R' && msg.length >= sizeof(FeedDirectoryMessage)) {
+                onDirectory(packet + pos);
+            }
+            else if (msg.type == 'A' && msg.length >= sizeof(FeedAddOrderMessage)) {
+                onOrder(packet + pos, msg.type, provider);
+            }
+            else if ((msg.type == 'X' || msg.type == 'D') && msg.length >= sizeof(FeedOrderUpdateMessage)) {
+                onOrder(packet + pos, msg.type, provider);
+            }
+            pos += msg.length;
+        }
+        // A heartbeat carries the next sequence to expect
+        nextSequence = std::max(nextSequence, sequence);
+        return static_cast<size_t>(stats.quotes - before);
+    }
+
+    const FeedStats& getStats() const { return stats; }
+    FeedStats& mutableStats() { return stats; }
+};
+
+void FeedDecoder::onQuote(const uint8_t* msg, MarketDataProvider& provider) {
+    FeedQuoteMessage quote;
+    std::memcpy(&quote, msg, sizeof(quote));
+    SymbolId id = quote.instrument < instruments.size() ? instruments[quote.instrument] : INVALID_SYMBOL;
+    if (id == INVALID_SYMBOL) {
+        stats.unknownSymbols++;
+        return;
+    }
+    MarketData data;
+    data.symbol = id;
+    data.bid = fromFeedPrice(quote.bid);
+    data.ask = fromFeedPrice(quote.ask);
+    data.last = fromFeedPrice(quote.last);
+    data.volume = quote.volume;
+    data.timestamp = quote.timestamp;
+    provider.publish(data);
+    stats.quotes++;
+}
+
+// Order messages are dropped unless the provider keeps books. When one moves
+// the best bid or ask, the new touch is published as a quote so getData and
+// the strategies see it like any other tick.
+void FeedDecoder::onOrder(const uint8_t* msg, char type, MarketDataProvider& provider) {
+    BookStore* books = provider.getBooks();
+    if (books == nullptr) return;
+
+    SymbolId id;
+    int64_t timestamp;
+    bool moved;
+    if (type == 'A') {
+        FeedAddOrderMessage add;
+        std::memcpy(&add, msg, sizeof(add));
+        id = add.instrument < instruments.size() ? instruments[add.instrument] : INVALID_SYMBOL;
+        if (id == INVALID_SYMBOL) {
+            stats.unknownSymbols++;
+            return;
+        }
+        if (add.quantity <= 0 || books->hasOrder(add.order)) {
+            stats.malformed++;
+            return;
+        }
+        timestamp = add.timestamp;
+        moved = books->addOrder(add.order, id, add.side == 'S' ? BOOK_ASK : BOOK_BID,
+            fromFeedPrice(add.price), add.quantity);
+    }
+    else {
+        FeedOrderUpdateMessage update;
+        std::memcpy(&update, msg, sizeof(update));
+        id = books->orderSymbol(update.order);
+        if (id == INVALID_SYMBOL) {
+            stats.unknownOrders++;
+            return;
+        }
+        if (type == 'X' && update.quantity <= 0) {
+            stats.malformed++;
+            return;
+        }
+        timestamp = update.timestamp;
+        moved = type == 'D' ? books->deleteOrder(update.order) : books->reduceOrder(update.order, update.quantity);
+    }
+    stats.orders++;
+
+    MarketData data = provider.getData(id);
+    if (!moved || !books->bestPrices(id, data.bid, data.ask)) return;
+    if (data.last == 0) data.last = (data.bid + data.ask) / 2.0;
+    data.symbol = id;
+    data.timestamp = timestamp;
+    provider.publish(data);
+    stats.quotes++;
+}
+
+// Packs quotes into packets for FeedPublisher; the directory for the whole
+// universe goes out first and again every FEED_DIRECTORY_INTERVAL packets
+// so late joiners can resolve instruments
+class FeedEncoder {
+private:
+    uint8_t buffer[FEED_MAX_PACKET];
+    size_t length;
+    uint16_t count;
+    uint64_t sequence;
+
+    void begin() {
+        length = sizeof(FeedPacketHeader);
+        count = 0;
+    }
+
+    template <typename Message>
+    bool append(const Message& msg) {
+        if (length + sizeof(msg) > FEED_MAX_PACKET) return false;
+        std::memcpy(buffer + length, &msg, sizeof(msg));
+        length += sizeof(msg);
+        count++;
+        return true;
+    }
+
+public:
+    FeedEncoder() : length(0), count(0), sequence(1) { begin(); }
+
+    bool empty() const { return count == 0; }
+
+    // Finishes the packet and hands it to send(data, length)
+    template <typename Send>
+    void flush(Send&& send) {
+        FeedPacketHeader header;
+        header.sequence = sequence;
+        header.count = count;
+        header.version = FEED_PROTOCOL_VERSION;
+        header.session = FEED_SESSION_MAGIC;
+        std::memcpy(buffer, &header, sizeof(header));
+        send(buffer, length);
+        sequence += count;
+        begin();
+    }
+
+    template <typename Send>
+    void directory(uint32_t instrument, const std::string& symbol, Send&& send) {
+        FeedDirectoryMessage msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.header.length = sizeof(msg);
+        msg.header.type = 'R';
+        msg.instrument = instrument;
+        std::memcpy(msg.symbol, symbol.data(), std::min(symbol.size(), FEED_SYMBOL_CHARS));
+        if (!append(msg)) {
+            flush(send);
+            append(msg);
+        }
+    }
+
+    template <typename Send>
+    void quote(const MarketData& data, Send&& send) {
+        FeedQuoteMessage msg;
+        msg.header.length = sizeof(msg);
+        msg.header.type = 'Q';
+        msg.header.reserved = 0;
+        msg.instrument = data.symbol;
+        msg.timestamp = data.timestamp;
+        msg.bid = toFeedPrice(data.bid);
+        msg.ask = toFeedPrice(data.ask);
+        msg.last = toFeedPrice(data.last);
+        msg.volume = data.volume;
+        if (!append(msg)) {
+            flush(send);
+            append(msg);
+        }
+    }
+};
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+inline void closeSocket(SocketHandle s) { closesocket(s); }
+inline int lastSocketError() { return WSAGetLastError(); }
+#else
+using SocketHandle = int;
+const SocketHandle NO_SOCKET = -1;
+inline void closeSocket(SocketHandle s) { ::close(s); }
+inline int lastSocketError() { return errno; }
+#endif
+
+bool initSockets() {
+#ifdef _WIN32
+    static bool started = false;
+    if (!started) {
+        WSADATA wsa;
+        started = WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+    }
+    return started;
+#else
+    return true;
+#endif
+}
+
+void setReceiveTimeout(SocketHandle s, int millis) {
+#ifdef _WIN32
+    DWORD timeout = static_cast<DWORD>(millis);
+#else
+    timeval timeout;
+    timeout.tv_sec = millis / 1000;
+    timeout.tv_usec = (millis % 1000) * 1000;
+#endif
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+// udp://HOST:PORT or tcp://HOST:PORT
+struct FeedEndpoint {
+    bool tcp;
+    std::string host;
+    uint16_t port;
+};
+
+bool parseFeedEndpoint(const std::string& url, FeedEndpoint& endpoint, std::string& error) {
+    size_t scheme = url.find("://");
+    size_t colon = url.rfind(':');
+    if (scheme == std::string::npos || colon == std::string::npos || colon < scheme + 3) {
+        error = "expected udp://HOST:PORT or tcp://HOST:PORT";
+        return false;
+    }
+    std::string proto = url.substr(0, scheme);
+    if (proto != "udp" && proto != "tcp") {
+        error = "unknown protocol '" + proto + "'";
+        return false;
+    }
+    const char* digits = url.c_str() + colon + 1;
+    char* end = nullptr;
+    long port = std::strtol(digits, &end, 10);
+    if (!std::isdigit(static_cast<unsigned char>(*digits)) || *end != '\0' || port <= 0 || port > 65535) {
+        error = "bad port";
+        return false;
+    }
+    endpoint.tcp = proto == "tcp";
+    endpoint.host = url.substr(scheme + 3, colon - scheme - 3);
+    endpoint.port = static_cast<uint16_t>(port);
+    return true;
+}
+
+bool resolveIpv4(const std::string& host, uint16_t port, sockaddr_in& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (host.empty() || host == "*") {
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        return true;
+    }
+    return inet_pton(AF_INET, host.c_str(), &addr.sin_addr) == 1;
+}
+
+inline bool isMulticast(const sockaddr_in& addr) {
+    return (ntohl(addr.sin_addr.s_addr) >> 28) == 0xE;
+}
+
+// Receives datagrams on a unicast port or joins a multicast group. Linux
+// drains up to FEED_RECV_BATCH datagrams per recvmmsg() into preallocated
+// buffers; elsewhere it falls back to one recvfrom() per datagram.
+class UdpFeedReceiver : public FeedHandler {
+private:
+    static const size_t FEED_RECV_BATCH = 64;
+
+    FeedEndpoint endpoint;
+    FeedDecoder decoder;
+    SocketHandle sock;
+    std::vector<uint8_t> buffers;  // FEED_RECV_BATCH slots of FEED_MAX_PACKET bytes
+#ifdef __linux__
+    std::vector<mmsghdr> headers;
+    std::vector<iovec> vectors;
+#endif
+
+public:
+    UdpFeedReceiver(const FeedEndpoint& ep, const SymbolTable& symbols)
+        : endpoint(ep), decoder(symbols), sock(NO_SOCKET), buffers(FEED_RECV_BATCH * FEED_MAX_PACKET) {
+#ifdef __linux__
+        headers.resize(FEED_RECV_BATCH);
+        vectors.resize(FEED_RECV_BATCH);
+        for (size_t i = 0; i < FEED_RECV_BATCH; i++) {
+            vectors[i].iov_base = &buffers[i * FEED_MAX_PACKET];
+            vectors[i].iov_len = FEED_MAX_PACKET;
+            std::memset(&headers[i], 0, sizeof(mmsghdr));
+            headers[i].msg_hdr.msg_iov = &vectors[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+#endif
+    }
+
+    bool open(std::string& error) {
+        sockaddr_in addr;
+        if (!initSockets() || !resolveIpv4(endpoint.host, endpoint.port, addr)) {
+            error = "cannot resolve " + endpoint.host;
+            return false;
+        }
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sock == NO_SOCKET) {
+            error = "socket() failed: " + systemErrorText(lastSocketError());
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+        int rcvbuf = 8 << 20;  // absorb bursts while the feed thread is descheduled
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&rcvbuf), sizeof(rcvbuf));
+        if (bind(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            error = "bind failed: " + systemErrorText(lastSocketError());
+            return false;
+        }
+        if (isMulticast(addr)) {
+            ip_mreq group;
+            group.imr_multiaddr = addr.sin_addr;
+            group.imr_interface.s_addr = htonl(INADDR_ANY);
+            if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, reinterpret_cast<const char*>(&group), sizeof(group)) != 0) {
+                error = "cannot join group: " + systemErrorText(lastSocketError());
+                return false;
+            }
+        }
+        setReceiveTimeout(sock, FEED_POLL_TIMEOUT_MS);
+        return true;
+    }
+
+    size_t poll(MarketDataProvider& provider) override {
+        size_t quotes = 0;
+#ifdef __linux__
+        int received = recvmmsg(sock, headers.data(), FEED_RECV_BATCH, MSG_WAITFORONE, nullptr);
+        for (int i = 0; i < received; i++) {
+            quotes += decoder.decode(&buffers[i * FEED_MAX_PACKET], headers[i].msg_len, provider);
+        }
+#else
+        int received = recv(sock, reinterpret_cast<char*>(buffers.data()), static_cast<int>(FEED_MAX_PACKET), 0);
+        if (received > 0) quotes += decoder.decode(buffers.data(), static_cast<size_t>(received), provider);
+#endif
+        return quotes;
+    }
+
+    const FeedStats& getStats() const override { return decoder.getStats(); }
+
+    std::string describe() const override {
+        return "udp://" + endpoint.host + ":" + std::to_string(endpoint.port);
+    }
+
+    ~UdpFeedReceiver() {
+        if (sock != NO_SOCKET) closeSocket(sock);
+    }
+};
+
+// Connects to a TCP feed and reassembles length-prefixed packets in a fixed
+// buffer, decoding each complete packet in place. Reconnects after a drop.
+class TcpFeedReceiver : public FeedHandler {
+private:
+    static const size_t TCP_BUFFER = 1 << 16;
+
+    FeedEndpoint endpoint;
+    FeedDecoder decoder;
+    SocketHandle sock;
+    std::vector<uint8_t> buffer;
+    size_t filled;
+
+    bool connectOnce(std::string& error) {
+        sockaddr_in addr;
+        if (!initSockets() || !resolveIpv4(endpoint.host, endpoint.port, addr)) {
+            error = "cannot resolve " + endpoint.host;
+            return false;
+        }
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (sock == NO_SOCKET) {
+            error = "socket() failed: " + systemErrorText(lastSocketError());
+            return false;
+        }
+        if (connect(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            error = "connect failed: " + systemErrorText(lastSocketError());
+            closeSocket(sock);
+            sock = NO_SOCKET;
+            return false;
+        }
+        int noDelay = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+        setReceiveTimeout(sock, FEED_POLL_TIMEOUT_MS);
+        filled = 0;
+        return true;
+    }
+
+public:
+    TcpFeedReceiver(const FeedEndpoint& ep, const SymbolTable& symbols)
+        : endpoint(ep), decoder(symbols), sock(NO_SOCKET), buffer(TCP_BUFFER), filled(0) {
+    }
+
+    bool open(std::string& error) { return connectOnce(error); }
+
+    size_t poll(MarketDataProvider& provider) override {
+        if (sock == NO_SOCKET) {
+            std::string error;
+            if (!connectOnce(error)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(FEED_POLL_TIMEOUT_MS));
+                return 0;
+            }
+        }
+        int received = recv(sock, reinterpret_cast<char*>(buffer.data() + filled),
+            static_cast<int>(buffer.size() - filled), 0);
+        if (received == 0 || (received < 0 && lastSocketError() != EAGAIN
+#ifdef _WIN32
+            && lastSocketError() != WSAETIMEDOUT
+#else
+            && lastSocketError() != EWOULDBLOCK && lastSocketError() != EINTR
+#endif
+            )) {
+            closeSocket(sock);
+            sock = NO_SOCKET;
+            return 0;
+        }
+        if (received < 0) return 0;
+        filled += static_cast<size_t>(received);
+
+        size_t quotes = 0;
+        size_t pos = 0;
+        while (filled - pos >= sizeof(uint16_t)) {
+            uint16_t frame;
+            std::memcpy(&frame, &buffer[pos], sizeof(frame));
+            if (frame == 0 || frame > FEED_MAX_PACKET) {
+                // Lost framing; nothing after this point can be trusted
+                decoder.mutableStats().malformed++;
+                closeSocket(sock);
+                sock = NO_SOCKET;
+                return quotes;
+            }
+            if (filled - pos < sizeof(frame) + frame) break;
+            quotes += decoder.decode(&buffer[pos + sizeof(frame)], frame, provider);
+            pos += sizeof(frame) + frame;
+        }
+        if (pos > 0) {
+            std::memmove(buffer.data(), buffer.data() + pos, filled - pos);
+            filled -= pos;
+        }
+        return quotes;
+    }
+
+    const FeedStats& getStats() const override { return decoder.getStats(); }
+
+    std::string describe() const override {
+        return "tcp://" + endpoint.host + ":" + std::to_string(endpoint.port);
+    }
+
+    ~TcpFeedReceiver() {
+        if (sock != NO_SOCKET) closeSocket(sock);
+    }
+};
+
+std::unique_ptr<FeedHandler> openFeedHandler(const std::string& url, const SymbolTable& symbols, std::string& error) {
+    FeedEndpoint endpoint;
+    if (!parseFeedEndpoint(url, endpoint, error)) return nullptr;
+    if (endpoint.tcp) {
+        std::unique_ptr<TcpFeedReceiver> feed = std::make_unique<TcpFeedReceiver>(endpoint, symbols);
+        if (!feed->open(error)) return nullptr;
+        return feed;
+    }
+    std::unique_ptr<UdpFeedReceiver> feed = std::make_unique<UdpFeedReceiver>(endpoint, symbols);
+    if (!feed->open(error)) return nullptr;
+    return feed;
+}
+
+// Sends the simulated feed as UDP packets in the wire format above, so a
+// second process can trade it with --feed. Runs until stop().
+class FeedPublisher {
+private:
+    static const uint64_t FEED_DIRECTORY_INTERVAL = 1000;  // packets between directory repeats
+
+    const SymbolTable& symbols;
+    FeedEndpoint endpoint;
+    sockaddr_in target;
+    SocketHandle sock;
+    GbmSimulator simulator;
+    FeedEncoder encoder;
+    int64_t tickInterval;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> packets;
+    std::atomic<uint64_t> quotes;
+    uint64_t sendErrors;
+    std::thread sendThread;
+
+    void send(const uint8_t* data, size_t length) {
+        int sent = sendto(sock, reinterpret_cast<const char*>(data), static_cast<int>(length), 0,
+            reinterpret_cast<const sockaddr*>(&target), sizeof(target));
+        if (sent < 0) sendErrors++;
+        packets.store(packets.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void sendDirectory() {
+        auto out = [this](const uint8_t* data, size_t length) { send(data, length); };
+        for (SymbolId id = 0; id < symbols.size(); id++) encoder.directory(id, symbols.name(id), out);
+        if (!encoder.empty()) encoder.flush(out);
+    }
+
+    void publishLoop() {
+        auto out = [this](const uint8_t* data, size_t length) { send(data, length); };
+        uint64_t nextDirectory = 0;
+        while (running) {
+            if (packets.load(std::memory_order_relaxed) >= nextDirectory) {
+                sendDirectory();
+                nextDirectory = packets.load(std::memory_order_relaxed) + FEED_DIRECTORY_INTERVAL;
+            }
+            simulator.step(wallClockNanos(), [&](const MarketData& data) { encoder.quote(data, out); });
+            if (!encoder.empty()) encoder.flush(out);
+            quotes.store(quotes.load(std::memory_order_relaxed) + symbols.size(), std::memory_order_relaxed);
+            if (tickInterval > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(tickInterval));
+        }
+    }
+
+public:
+    FeedPublisher(const SymbolTable& syms, const FeedEndpoint& ep, uint32_t seed,
+        FeedGenerator generator, int64_t intervalNanos)
+        : symbols(syms), endpoint(ep), sock(NO_SOCKET), simulator(syms.size(), seed, generator),
+        tickInterval(intervalNanos), running(false), packets(0), quotes(0), sendErrors(0) {
+        std::memset(&target, 0, sizeof(target));
+    }
+
+    bool open(std::string& error) {
+        if (endpoint.tcp) {
+            error = "publishing supports udp:// only";
+            return false;
+        }
+        if (!initSockets() || endpoint.host.empty() || !resolveIpv4(endpoint.host, endpoint.port, target)) {
+            error = "cannot resolve " + endpoint.host;
+            return false;
+        }
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sock == NO_SOCKET) {
+            error = "socket() failed: " + systemErrorText(lastSocketError());
+            return false;
+        }
+        if (isMulticast(target)) {
+            unsigned char ttl = 1;  // keep test traffic on the local segment
+            setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, reinterpret_cast<const char*>(&ttl), sizeof(ttl));
+        }
+        return true;
+    }
+
+    void start() {
+        running = true;
+        sendThread = std::thread(&FeedPublisher::publishLoop, this);
+    }
+
+    void stop() {
+        running = false;
+        if (sendThread.joinable()) sendThread.join();
+    }
+
+    uint64_t getPackets() const { return packets.load(std::memory_order_relaxed); }
+    uint64_t getQuotes() const { return quotes.load(std::memory_order_relaxed); }
+    uint64_t getSendErrors() const { return sendErrors; }
+
+    ~FeedPublisher() {
+        stop();
+        if (sock != NO_SOCKET) closeSocket(sock);
+    }
+};
+
+void printFeedStats(const FeedStats& stats) {
+    std::cout << Color::CYAN << "[FEED] Packets: " << stats.packets << " | Messages: " << stats.messages
+        << " | Quotes: " << stats.quotes << " | Gaps: " << stats.gaps << " (" << stats.missed
+        << " missed) | Duplicates: " << stats.duplicates << " | Malformed: " << stats.malformed
+        << " | Unknown instruments: " << stats.unknownSymbols << " | Orders: " << stats.orders
+        << " (" << stats.unknownOrders << " unknown ids)\n" << Color::RESET;
+}
+
+enum LogLevel { LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_OFF };
+
+bool parseLogLevel(const std::string& text, LogLevel& level) {
+    if (text == "debug") level = LOG_DEBUG;
+    else if (text == "info") level = LOG_INFO;
+    else if (text == "warn") level = LOG_WARN;
+    else if (text == "off") level = LOG_OFF;
+    else return false;
+    return true;
+}
+
+enum LogEvent : uint8_t { LOG_BUY, LOG_SELL, LOG_REJECT };
+
+// Fixed-size binary record; formatting happens on the logger thread
+struct LogRecord {
+    LogEvent event;
+    uint8_t level;
+    StrategyId strategy;
+    SymbolId symbol;
+    int32_t quantity;
+    double price;
+    double amount;      // cost for buys, realized P&L for sells
+    int64_t wallNanos;  // wall (or simulated) time of the triggering tick
+    uint64_t cycles;    // cycleCounter() at the time of the event
+};
+
+const size_t LOG_RING_CAPACITY = 65536;
+
+// Asynchronous logger: the trading path copies a LogRecord into a lock-free
+// ring and returns; a background thread formats and writes it to the
+// console or a file. A full ring drops the record instead of blocking.
+class AsyncLogger {
+private:
+    const SymbolTable& symbols;
+    const std::vector<std::string>& strategyNames;
+    MpscQueue<LogRecord> ring;
+    LogLevel level;
+    std::ofstream file;
+    std::ostream* out;
+    bool colors;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> dropped;
+    std::thread writer;
+
+    void format(const LogRecord& rec) {
+        std::ostream& os = *out;
+        const std::string& name = strategyNames[rec.strategy];
+        std::string time = formatTime(rec.wallNanos);
+
+        if (rec.event == LOG_BUY) {
+            os << (colors ? Color::GREEN : "") << "[" << time << "] BUY  "
+                << std::setw(6) << symbols.name(rec.symbol) << " " << std::setw(3) << rec.quantity
+                << " @ $" << std::fixed << std::setprecision(2) << rec.price
+                << " | Cost: $" << std::setprecision(2) << rec.amount
+                << " (" << name << ")" << (colors ? Color::RESET : "") << "\n";
+        }
+        else if (rec.event == LOG_SELL) {
+            const std::string& pnlColor = (rec.amount >= 0) ? Color::GREEN : Color::RED;
+            os << (colors ? Color::RED : "") << "[" << time << "] SELL "
+                << std::setw(6) << symbols.name(rec.symbol) << " " << std::setw(3) << rec.quantity
+                << " @ $" << std::fixed << std::setprecision(2) << rec.price
+                << " | " << (colors ? pnlColor : "") << "P&L: $" << std::setprecision(2) << rec.amount
+                << (colors ? Color::RESET : "") << " (" << name << ")" << (colors ? Color::RESET : "") << "\n";
+        }
+        else {
+            os << (colors ? Color::YELLOW : "") << "[" << time << "] REJECT "
+                << std::setw(6) << symbols.name(rec.symbol) << " " << std::setw(3) << rec.quantity
+                << " @ $" << std::fixed << std::setprecision(2) << rec.price
+                << " (" << name << ")" << (colors ? Color::RESET : "") << "\n";
+        }
+    }
+
+    void writerLoop() {
+        LogRecord rec;
+        while (true) {
+            bool wrote = false;
+            while (ring.pop(rec)) {
+                HFT_PROFILE_SCOPE(PROFILE_LOG_WRITE);
+                format(rec);
+                wrote = true;
+            }
+            if (wrote) {
+                out->flush();
+            }
+            else if (!running) {
+                break;
+            }
+            else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+public:
+    // An empty path logs to the console with colors
+    AsyncLogger(const SymbolTable& syms, const std::vector<std::string>& names,
+        LogLevel logLevel, const std::string& path)
+        : symbols(syms), strategyNames(names), ring(LOG_RING_CAPACITY), level(logLevel),
+        out(&std::cout), colors(true), running(false), dropped(0) {
+        if (!path.empty()) {
+            file.open(path, std::ios::out | std::ios::app);
+            if (file) {
+                out = &file;
+                colors = false;
+            }
+            else {
+                std::cout << Color::RED << "[LOG] Cannot open " << path
+                    << ", logging to console\n" << Color::RESET;
+            }
+        }
+    }
+
+    void start() {
+        running = true;
+        writer = std::thread(&AsyncLogger::writerLoop, this);
+    }
+
+    // Flushes everything still queued before returning
+    void stop() {
+        running = false;
+        if (writer.joinable()) writer.join();
+    }
+
+    bool enabled(LogLevel recordLevel) const { return recordLevel >= level && level != LOG_OFF; }
+
+    void log(const LogRecord& rec) {
+        HFT_PROFILE_SCOPE(PROFILE_LOG_ENQUEUE);
+        if (!ring.push(rec)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    std::thread& getWriterThread() { return writer; }
+
+    ~AsyncLogger() { stop(); }
+};
+
+// Portfolio sums are kept in fixed-point micro-dollars so concurrent deltas
+// add exactly and the totals never drift from the per-symbol values
+const double MONEY_SCALE = 1e6;
+
+inline int64_t toMoneyUnits(double dollars) {
+    return static_cast<int64_t>(std::llround(dollars * MONEY_SCALE));
+}
+
+inline double fromMoneyUnits(int64_t units) {
+    return units / MONEY_SCALE;
+}
+
+const double COMMISSION_RATE = 0.001;
+
+struct HoldingView {
+    int quantity;
+    double mark;  // last price the holding was valued at; 0 if never marked
+};
+
+// Keeps the open-position count, marked value and cost basis current on
+// every fill and every tick instead of rescanning positions on each read.
+// A per-symbol spinlock orders the fill writer against the thread marking
+// that symbol; the totals are atomic sums of the per-symbol contributions,
+// so reads are O(1) and lock-free (each total is individually consistent).
+class PortfolioAccountant {
+private:
+    struct alignas(CACHE_LINE) Holding {
+        std::atomic<bool> locked;
+        int quantity;
+        double mark;
+        int64_t value;  // quantity * mark in money units
+        int64_t cost;   // cost basis in money units
+
+        Holding() : locked(false), quantity(0), mark(0.0), value(0), cost(0) {}
+    };
+
+    std::vector<Holding> holdings;
+    alignas(CACHE_LINE) std::atomic<int64_t> marketValue;
+    std::atomic<int64_t> costBasis;
+    std::atomic<int> openPositions;
+
+    static void lock(Holding& h) {
+        while (h.locked.exchange(true, std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    static void unlock(Holding& h) {
+        h.locked.store(false, std::memory_order_release);
+    }
+
+    // Caller holds h's lock
+    void revalue(Holding& h) {
+        int64_t value = toMoneyUnits(h.quantity * h.mark);
+        if (value != h.value) {
+            marketValue.fetch_add(value - h.value, std::memory_order_relaxed);
+            h.value = value;
+        }
+    }
+
+public:
+    explicit PortfolioAccountant(size_t symbols)
+        : holdings(symbols), marketValue(0), costBasis(0), openPositions(0) {
+    }
+
+    // Tick path: revalues the holding at the latest price
+    void mark(SymbolId symbol, double price) {
+        Holding& h = holdings[symbol];
+        lock(h);
+        h.mark = price;
+        if (h.quantity != 0) revalue(h);
+        unlock(h);
+    }
+
+    // Fill path: records the position after a fill; fillPrice marks a
+    // holding that has not been priced yet
+    void update(SymbolId symbol, int quantity, double totalCost, double fillPrice) {
+        Holding& h = holdings[symbol];
+        lock(h);
+        if ((h.quantity > 0) != (quantity > 0)) {
+            openPositions.fetch_add(quantity > 0 ? 1 : -1, std::memory_order_relaxed);
+        }
+        int64_t cost = toMoneyUnits(totalCost);
+        costBasis.fetch_add(cost - h.cost, std::memory_order_relaxed);
+        h.cost = cost;
+        h.quantity = quantity;
+        if (h.mark <= 0) h.mark = fillPrice;
+        revalue(h);
+        unlock(h);
+    }
+
+    HoldingView holding(SymbolId symbol) {
+        Holding& h = holdings[symbol];
+        lock(h);
+        HoldingView view;
+        view.quantity = h.quantity;
+        view.mark = h.mark;
+        unlock(h);
+        return view;
+    }
+
+    double getMarketValue() const { return fromMoneyUnits(marketValue.load(std::memory_order_relaxed)); }
+    double getCostBasis() const { return fromMoneyUnits(costBasis.load(std::memory_order_relaxed)); }
+    int getOpenPositions() const { return openPositions.load(std::memory_order_relaxed); }
+};
+
+const size_t MAX_TRIGGERS_PER_SYMBOL = 4;
+
+enum TriggerKind { TRIGGER_STOP, TRIGGER_TARGET, TRIGGER_KIND_COUNT };
+
+struct TriggerHit {
+    TriggerKind kind;
+    double price;  // level that was crossed
+};
+
+// A symbol's resting levels as plain data, for snapshots
+struct TriggerLevels {
+    uint32_t stopCount;
+    uint32_t targetCount;
+    double stopPrice[MAX_TRIGGERS_PER_SYMBOL];
+    double targetPrice[MAX_TRIGGERS_PER_SYMBOL];
+    int32_t stopQuantity[MAX_TRIGGERS_PER_SYMBOL];
+    int32_t targetQuantity[MAX_TRIGGERS_PER_SYMBOL];
+};
+
+// Resting stop-loss and take-profit levels for long positions. Each symbol
+// keeps its stops sorted highest first and its targets lowest first, with
+// the best of each mirrored in an atomic so the tick path decides with two
+// loads and two compares. Levels are only changed by the thread that fills
+// orders; any thread may check.
+class TriggerBook {
+private:
+    struct Level {
+        double price;
+        int quantity;
+    };
+
+    struct alignas(CACHE_LINE) SymbolTriggers {
+        std::atomic<double> bestStop;    // 0 when no stop rests
+        std::atomic<double> bestTarget;  // +inf when no target rests
+        Level stops[MAX_TRIGGERS_PER_SYMBOL];
+        Level targets[MAX_TRIGGERS_PER_SYMBOL];
+        uint32_t stopCount;
+        uint32_t targetCount;
+
+        SymbolTriggers() : bestStop(0.0), bestTarget(std::numeric_limits<double>::infinity()),
+            stopCount(0), targetCount(0) {
+        }
+    };
+
+    std::vector<SymbolTriggers> book;
+
+    // Exit quality, written by the filling thread only
+    uint64_t exits[TRIGGER_KIND_COUNT];
+    double slippageBps[TRIGGER_KIND_COUNT];  // sum; positive is worse than the level
+    double worstBps[TRIGGER_KIND_COUNT];
+
+    // Inserts keeping levels[0] the best; a full ladder drops its worst level
+    template <typename Better>
+    static void insert(Level* levels, uint32_t& count, Level level, Better better) {
+        uint32_t pos = std::min<uint32_t>(count, MAX_TRIGGERS_PER_SYMBOL - 1);
+        while (pos > 0 && better(level.price, levels[pos - 1].price)) {
+            if (pos < MAX_TRIGGERS_PER_SYMBOL) levels[pos] = levels[pos - 1];
+            pos--;
+        }
+        if (count == MAX_TRIGGERS_PER_SYMBOL && pos == MAX_TRIGGERS_PER_SYMBOL - 1 &&
+            !better(level.price, levels[pos].price)) {
+            return;
+        }
+        levels[pos] = level;
+        if (count < MAX_TRIGGERS_PER_SYMBOL) count++;
+    }
+
+public:
+    explicit TriggerBook(size_t symbols) : book(symbols) {
+        for (int k = 0; k < TRIGGER_KIND_COUNT; k++) {
+            exits[k] = 0;
+            slippageBps[k] = 0.0;
+            worstBps[k] = 0.0;
+        }
+    }
+
+    // Rests a stop and a target for quantity shares; a non-positive level is skipped
+    void arm(SymbolId symbol, double stop, double target, int quantity) {
+        SymbolTriggers& t = book[symbol];
+        if (stop > 0) {
+            insert(t.stops, t.stopCount, Level{ stop, quantity }, [](double a, double b) { return a > b; });
+            t.bestStop.store(t.stops[0].price, std::memory_order_release);
+        }
+        if (target > 0) {
+            insert(t.targets, t.targetCount, Level{ target, quantity }, [](double a, double b) { return a < b; });
+            t.bestTarget.store(t.targets[0].price, std::memory_order_release);
+        }
+    }
+
+    // Cancels every resting level, once the position is flat
+    void clear(SymbolId symbol) {
+        SymbolTriggers& t = book[symbol];
+        t.stopCount = 0;
+        t.targetCount = 0;
+        t.bestStop.store(0.0, std::memory_order_release);
+        t.bestTarget.store(std::numeric_limits<double>::infinity(), std::memory_order_release);
+    }
+
+    void save(SymbolId symbol, TriggerLevels& out) const {
+        const SymbolTriggers& t = book[symbol];
+        std::memset(&out, 0, sizeof(out));
+        out.stopCount = t.stopCount;
+        out.targetCount = t.targetCount;
+        for (uint32_t i = 0; i < t.stopCount; i++) {
+            out.stopPrice[i] = t.stops[i].price;
+            out.stopQuantity[i] = t.stops[i].quantity;
+        }
+        for (uint32_t i = 0; i < t.targetCount; i++) {
+            out.targetPrice[i] = t.targets[i].price;
+            out.targetQuantity[i] = t.targets[i].quantity;
+        }
+    }
+
+    void restore(SymbolId symbol, const TriggerLevels& levels) {
+        clear(symbol);
+        for (uint32_t i = 0; i < std::min<uint32_t>(levels.stopCount, MAX_TRIGGERS_PER_SYMBOL); i++) {
+            arm(symbol, levels.stopPrice[i], 0, levels.stopQuantity[i]);
+        }
+        for (uint32_t i = 0; i < std::min<uint32_t>(levels.targetCount, MAX_TRIGGERS_PER_SYMBOL); i++) {
+            arm(symbol, 0, levels.targetPrice[i], levels.targetQuantity[i]);
+        }
+    }
+
+    // O(1): does a sale at bid cross the best stop or target?
+    bool check(SymbolId symbol, double bid, TriggerHit& hit) const {
+        const SymbolTriggers& t = book[symbol];
+        double stop = t.bestStop.load(std::memory_order_acquire);
+        if (bid <= stop) {
+            hit.kind = TRIGGER_STOP;
+            hit.price = stop;
+            return true;
+        }
+        double target = t.bestTarget.load(std::memory_order_acquire);
+        if (bid >= target) {
+            hit.kind = TRIGGER_TARGET;
+            hit.price = target;
+            return true;
+        }
+        return false;
+    }
+
+    void recordExit(TriggerKind kind, double level, double fillPrice) {
+        double bps = (level - fillPrice) / level * 10000.0;
+        exits[kind]++;
+        slippageBps[kind] += bps;
+        worstBps[kind] = std::max(worstBps[kind], bps);
+    }
+
+    void printReport() const {
+        const char* names[TRIGGER_KIND_COUNT] = { "stop", "target" };
+        std::cout << Color::CYAN << "[EXITS]";
+        for (int k = 0; k < TRIGGER_KIND_COUNT; k++) {
+            double avg = exits[k] > 0 ? slippageBps[k] / exits[k] : 0.0;
+            std::cout << (k == 0 ? " " : " | ") << names[k] << ": " << exits[k]
+                << " fills, slippage avg " << std::fixed << std::setprecision(2) << avg
+                << " bps, worst " << worstBps[k] << " bps";
+        }
+        std::cout << "\n" << Color::RESET;
+    }
+};
+
+const char JOURNAL_FILE_MAGIC[8] = { 'H', 'F', 'T', 'J', 'R', 'N', 'L', '1' };
+const char SNAPSHOT_FILE_MAGIC[8] = { 'H', 'F', 'T', 'S', 'N', 'A', 'P', '1' };
+const uint32_t JOURNAL_FILE_VERSION = 1;
+const size_t JOURNAL_HEADER_BYTES = 4096;     // the ring starts on its own page
+const size_t DEFAULT_JOURNAL_RECORDS = 65536;  // 6 MB ring
+const size_t MIN_JOURNAL_RECORDS = 1024;       // below this the ring snapshots every few hundred fills
+const size_t MAX_JOURNAL_RECORDS = 1 << 24;    // 1.5 GB ring
+const int JOURNAL_COMMIT_INTERVAL_MS = 5;      // group commit: one msync per interval at most
+
+const uint64_t FNV_OFFSET = 0xCBF29CE484222325ULL;
+const uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+inline uint64_t fnv1a(const void* data, size_t length, uint64_t hash = FNV_OFFSET) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; i++) hash = (hash ^ bytes[i]) * FNV_PRIME;
+    return hash;
+}
+
+// Identifies the universe a journal was written for, in SymbolId order
+uint64_t universeHash(const SymbolTable& symbols) {
+    uint64_t hash = FNV_OFFSET;
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        hash = fnv1a(symbols.name(id).data(), symbols.name(id).size(), hash);
+        hash = fnv1a("\n", 1, hash);
+    }
+    return hash;
+}
+
+enum JournalEvent : uint32_t { JOURNAL_CAPITAL = 1, JOURNAL_BUY, JOURNAL_SELL };
+
+// One fill or cash event. It carries the account and position state after
+// the event, so replaying a record overwrites state instead of redoing the
+// fill arithmetic.
+struct JournalRecord {
+    uint64_t sequence;  // from 1; the record lives in ring slot (sequence - 1) % capacity
+    uint32_t type;      // JournalEvent
+    uint32_t checksum;  // see computeChecksum()
+    uint32_t symbol;
+    uint32_t strategy;
+    int32_t quantity;   // shares in this fill
+    int32_t position;   // shares held after it
+    double price;
+    double positionCost;
+    double cash;
+    double realizedPnL;
+    double pnl;         // sells: profit of this fill
+    double stopLoss;    // buys: levels armed for the new shares
+    double takeProfit;
+    int64_t timestamp;
+
+    // FNV-1a over whole words, skipping the one that holds type and the
+    // checksum itself (type is mixed in first): cheap enough for every fill
+    uint32_t computeChecksum() const {
+        uint64_t words[12];
+        std::memcpy(words, this, sizeof(words));
+        uint64_t hash = (FNV_OFFSET ^ type) * FNV_PRIME;
+        for (size_t i = 0; i < 12; i++) {
+            if (i != 1) hash = (hash ^ words[i]) * FNV_PRIME;
+        }
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+};
+
+struct JournalFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;      // records in the ring
+    uint64_t symbolHash;
+    double initialCapital;  // 0 until a session has started on this journal
+    uint64_t reserved[3];
+};
+
+static_assert(sizeof(JournalRecord) == 96, "JournalRecord layout is part of the file format");
+static_assert(sizeof(JournalFileHeader) == 64, "JournalFileHeader layout is part of the file format");
+
+struct SnapshotFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t positionCount;
+    uint64_t sequence;  // last journal record the snapshot includes
+    uint64_t symbolHash;
+    double initialCapital;
+    double cash;
+    double realizedPnL;
+    uint32_t trades;
+    uint32_t wins;
+    uint32_t losses;
+    uint32_t reserved;
+    uint64_t checksum;  // FNV-1a of the header with this field zeroed, then the positions
+};
+
+struct SnapshotPosition {
+    uint32_t symbol;
+    int32_t quantity;
+    double totalCost;
+    double mark;
+    TriggerLevels triggers;
+};
+
+static_assert(sizeof(SnapshotFileHeader) == 80, "SnapshotFileHeader layout is part of the file format");
+static_assert(sizeof(SnapshotPosition) == 128, "SnapshotPosition layout is part of the file format");
+
+// Account state at one journal sequence; only open positions are kept
+struct EngineSnapshot {
+    uint64_t sequence;
+    double initialCapital;
+    double cash;
+    double realizedPnL;
+    uint32_t trades;
+    uint32_t wins;
+    uint32_t losses;
+    std::vector<SnapshotPosition> positions;
+
+    EngineSnapshot() : sequence(0), initialCapital(0), cash(0), realizedPnL(0), trades(0), wins(0), losses(0) {}
+};
+
+// Crash-safe fill journal: a ring of fixed records in a memory-mapped file
+// next to a snapshot file (PATH.snap). The filling thread copies each record
+// into the mapping, which the page cache keeps even if the process dies; a
+// commit thread msyncs whatever was written since its last pass, so the
+// disk sees one flush per JOURNAL_COMMIT_INTERVAL_MS however many fills
+// there were. Snapshots let the ring wrap: a record is only overwritten
+// once a snapshot covers it, and recovery loads the snapshot and replays
+// the records after it.
+class WriteAheadJournal {
+private:
+    std::string path;
+    std::string snapshotPath;
+    char* base;
+    size_t length;
+    JournalFileHeader* header;
+    JournalRecord* ring;
+    uint64_t capacity;
+    uint64_t symbolHash;
+    size_t symbolCount;  // a snapshot holds at most one position per symbol
+    size_t pageSize;
+    uint64_t nextSequence;                 // filling thread
+    std::atomic<uint64_t> written;         // last record copied into the ring
+    std::atomic<uint64_t> durable;         // last record flushed to disk
+    std::atomic<uint64_t> checkpointed;    // last record covered by the snapshot on disk
+    std::mutex commitMutex;
+    std::mutex checkpointMutex;
+    std::atomic<uint64_t> commits;
+    std::atomic<uint64_t> checkpoints;
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mapping;
+#endif
+
+    void unmap() {
+#ifdef _WIN32
+        if (base != nullptr) UnmapViewOfFile(base);
+        if (mapping != nullptr) CloseHandle(mapping);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mapping = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (base != nullptr) munmap(base, length);
+#endif
+        base = nullptr;
+        header = nullptr;
+        ring = nullptr;
+        length = 0;
+    }
+
+    // Maps the file read-write, creating it at `bytes` if it is new
+    bool map(size_t bytes, bool& created) {
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+        created = GetLastError() != ERROR_ALREADY_EXISTS;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fileHandle, &size)) return false;
+        if (size.QuadPart == 0) created = true;
+        if (!created) bytes = static_cast<size_t>(size.QuadPart);
+        mapping = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32), static_cast<DWORD>(bytes), nullptr);
+        if (mapping == nullptr) return false;
+        base = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, bytes));
+        length = bytes;
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        pageSize = info.dwPageSize;
+        return base != nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        created = st.st_size == 0;
+        if (created && ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        if (!created) bytes = static_cast<size_t>(st.st_size);
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        flags |= MAP_POPULATE;  // fault the ring in now, not on the first fill into each page
+#endif
+        void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) return false;
+        base = static_cast<char*>(addr);
+        length = bytes;
+        pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return true;
+#endif
+    }
+
+    // Flushes ring records [first, last] (1-based sequences, no wrap)
+    void flushRange(uint64_t first, uint64_t last) {
+        size_t begin = JOURNAL_HEADER_BYTES + static_cast<size_t>((first - 1) % capacity) * sizeof(JournalRecord);
+        size_t end = JOURNAL_HEADER_BYTES + static_cast<size_t>((last - 1) % capacity + 1) * sizeof(JournalRecord);
+        flushBytes(begin, end);
+    }
+
+    void flushBytes(size_t begin, size_t end) {
+        begin = begin / pageSize * pageSize;
+#ifdef _WIN32
+        FlushViewOfFile(base + begin, end - begin);
+        FlushFileBuffers(fileHandle);
+#else
+        msync(base + begin, end - begin, MS_SYNC);
+#endif
+    }
+
+    static bool syncFile(std::FILE* file) {
+        if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    static bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+
+public:
+    WriteAheadJournal() : base(nullptr), length(0), header(nullptr), ring(nullptr), capacity(0), symbolHash(0),
+        symbolCount(0), pageSize(4096), nextSequence(1), written(0), durable(0), checkpointed(0), commits(0), checkpoints(0)
+#ifdef _WIN32
+        , fileHandle(INVALID_HANDLE_VALUE), mapping(nullptr)
+#endif
+    {
+    }
+
+    ~WriteAheadJournal() {
+        if (base != nullptr) commit();
+        unmap();
+    }
+
+    // Opens PATH, or creates it with a ring of `records`; an existing
+    // journal keeps its own ring size. Finds the end of the valid records.
+    bool open(const std::string& file, const SymbolTable& symbols, size_t records, std::string& error) {
+        path = file;
+        snapshotPath = file + ".snap";
+        symbolHash = universeHash(symbols);
+        symbolCount = symbols.size();
+        records = std::max(records, MIN_JOURNAL_RECORDS);
+        bool created = false;
+        if (!map(JOURNAL_HEADER_BYTES + records * sizeof(JournalRecord), created)) {
+            error = "cannot map " + path;
+            unmap();
+            return false;
+        }
+        header = reinterpret_cast<JournalFileHeader*>(base);
+        ring = reinterpret_cast<JournalRecord*>(base + JOURNAL_HEADER_BYTES);
+        if (created) {
+            std::memset(header, 0, sizeof(*header));
+            std::memcpy(header->magic, JOURNAL_FILE_MAGIC, sizeof(header->magic));
+            header->version = JOURNAL_FILE_VERSION;
+            header->recordSize = sizeof(JournalRecord);
+            header->capacity = records;
+            header->symbolHash = symbolHash;
+            flushBytes(0, JOURNAL_HEADER_BYTES);
+        }
+        if (length < JOURNAL_HEADER_BYTES || std::memcmp(header->magic, JOURNAL_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != JOURNAL_FILE_VERSION || header->recordSize != sizeof(JournalRecord) ||
+            header->capacity == 0 || JOURNAL_HEADER_BYTES + header->capacity * sizeof(JournalRecord) > length) {
+            error = "not a version 1 journal";
+            unmap();
+            return false;
+        }
+        if (header->symbolHash != symbolHash) {
+            error = "journal was written for a different universe";
+            unmap();
+            return false;
+        }
+        capacity = header->capacity;
+        return true;
+    }
+
+    bool hasState() const { return header != nullptr && header->initialCapital > 0; }
+    double getInitialCapital() const { return header->initialCapital; }
+    const std::string& getPath() const { return path; }
+
+    // First session on a new journal: records the starting cash
+    void begin(double capital) {
+        header->initialCapital = capital;
+        flushBytes(0, JOURNAL_HEADER_BYTES);
+        JournalRecord rec;
+        std::memset(&rec, 0, sizeof(rec));
+        rec.type = JOURNAL_CAPITAL;
+        rec.cash = capital;
+        rec.timestamp = wallClockNanos();
+        append(rec);
+        commit();
+    }
+
+    // Reads PATH.snap; false with an empty error when there is none yet
+    bool loadSnapshot(EngineSnapshot& snapshot, std::string& error) const {
+        std::FILE* file = std::fopen(snapshotPath.c_str(), "rb");
+        if (file == nullptr) return false;
+        SnapshotFileHeader head;
+        bool ok = std::fread(&head, sizeof(head), 1, file) == 1 &&
+            std::memcmp(head.magic, SNAPSHOT_FILE_MAGIC, sizeof(head.magic)) == 0 &&
+            head.version == JOURNAL_FILE_VERSION && head.symbolHash == symbolHash &&
+            head.positionCount <= symbolCount;  // checked before the checksum can vouch for it
+        if (ok) {
+            snapshot.positions.resize(head.positionCount);
+            ok = head.positionCount == 0 ||
+                std::fread(snapshot.positions.data(), sizeof(SnapshotPosition), head.positionCount, file) == head.positionCount;
+        }
+        std::fclose(file);
+        uint64_t expected = head.checksum;
+        head.checksum = 0;
+        if (ok) {
+            uint64_t hash = fnv1a(&head, sizeof(head));
+            hash = fnv1a(snapshot.positions.data(), snapshot.positions.size() * sizeof(SnapshotPosition), hash);
+            ok = hash == expected;
+        }
+        if (!ok) {
+            error = "snapshot " + snapshotPath + " is corrupt";
+            return false;
+        }
+        snapshot.sequence = head.sequence;
+        snapshot.initialCapital = head.initialCapital;
+        snapshot.cash = head.cash;
+        snapshot.realizedPnL = head.realizedPnL;
+        snapshot.trades = head.trades;
+        snapshot.wins = head.wins;
+        snapshot.losses = head.losses;
+        return true;
+    }
+
+    // Hands every valid record after `after` to apply, in order, and
+    // positions the writer after the last one. Returns how many there were.
+    template <typename Apply>
+    uint64_t replay(uint64_t after, Apply apply) {
+        uint64_t seq = after + 1;
+        while (true) {
+            const JournalRecord& rec = ring[(seq - 1) % capacity];
+            if (rec.sequence != seq || rec.checksum != rec.computeChecksum()) break;
+            apply(rec);
+            seq++;
+        }
+        nextSequence = seq;
+        written = seq - 1;
+        durable = seq - 1;
+        checkpointed = after;
+        return seq - 1 - after;
+    }
+
+    // Filling thread: false when the next record would overwrite one no
+    // snapshot covers yet, and a checkpoint has to come first
+    bool hasRoom() const { return nextSequence - checkpointed.load(std::memory_order_acquire) <= capacity; }
+
+    // Filling thread: one memcpy into the mapping
+    void append(JournalRecord& rec) {
+        rec.sequence = nextSequence++;
+        rec.checksum = 0;
+        rec.checksum = rec.computeChecksum();
+        std::memcpy(&ring[(rec.sequence - 1) % capacity], &rec, sizeof(rec));
+        written.store(rec.sequence, std::memory_order_release);
+    }
+
+    uint64_t lastSequence() const { return written.load(std::memory_order_acquire); }
+    uint64_t sinceCheckpoint() const { return lastSequence() - checkpointed.load(std::memory_order_relaxed); }
+
+    // Commit thread: flushes everything written since the last commit
+    void commit() {
+        std::lock_guard<std::mutex> lock(commitMutex);
+        uint64_t last = written.load(std::memory_order_acquire);
+        uint64_t first = durable.load(std::memory_order_relaxed) + 1;
+        if (last < first) return;
+        if (last - first + 1 >= capacity) {
+            flushBytes(JOURNAL_HEADER_BYTES, JOURNAL_HEADER_BYTES + static_cast<size_t>(capacity) * sizeof(JournalRecord));
+        }
+        else if ((first - 1) % capacity <= (last - 1) % capacity) {
+            flushRange(first, last);
+        }
+        else {
+            uint64_t wrap = first + (capacity - (first - 1) % capacity) - 1;  // last sequence before the wrap
+            flushRange(first, wrap);
+            flushRange(wrap + 1, last);
+        }
+        durable.store(last, std::memory_order_release);
+        commits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Writes the snapshot beside the journal (temp file, fsync, rename) and
+    // frees the ring up to its sequence. Any thread; older snapshots than
+    // the one on disk are ignored.
+    bool checkpoint(const EngineSnapshot& snapshot) {
+        std::lock_guard<std::mutex> lock(checkpointMutex);
+        if (snapshot.sequence < checkpointed.load(std::memory_order_relaxed)) return true;
+        // Records the snapshot depends on must be on disk first
+        commit();
+
+        SnapshotFileHeader head;
+        std::memset(&head, 0, sizeof(head));
+        std::memcpy(head.magic, SNAPSHOT_FILE_MAGIC, sizeof(head.magic));
+        head.version = JOURNAL_FILE_VERSION;
+        head.positionCount = static_cast<uint32_t>(snapshot.positions.size());
+        head.sequence = snapshot.sequence;
+        head.symbolHash = symbolHash;
+        head.initialCapital = snapshot.initialCapital;
+        head.cash = snapshot.cash;
+        head.realizedPnL = snapshot.realizedPnL;
+        head.trades = snapshot.trades;
+        head.wins = snapshot.wins;
+        head.losses = snapshot.losses;
+        uint64_t hash = fnv1a(&head, sizeof(head));
+        head.checksum = fnv1a(snapshot.positions.data(), snapshot.positions.size() * sizeof(SnapshotPosition), hash);
+
+        std::string temp = snapshotPath + ".tmp";
+        std::FILE* file = std::fopen(temp.c_str(), "wb");
+        if (file == nullptr) return false;
+        bool ok = std::fwrite(&head, sizeof(head), 1, file) == 1 &&
+            (snapshot.positions.empty() || std::fwrite(snapshot.positions.data(), sizeof(SnapshotPosition),
+                snapshot.positions.size(), file) == snapshot.positions.size());
+        ok = syncFile(file) && ok;
+        std::fclose(file);
+        if (!ok || !replaceFile(temp, snapshotPath)) return false;
+        checkpointed.store(snapshot.sequence, std::memory_order_release);
+        checkpoints.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    uint64_t getCommits() const { return commits.load(std::memory_order_relaxed); }
+    uint64_t getCheckpoints() const { return checkpoints.load(std::memory_order_relaxed); }
+    uint64_t getCapacity() const { return capacity; }
+};
+
+class TradingEngine {
+private:
+    const SymbolTable& symbols;
+    std::vector<PositionView> positions;
+    PortfolioAccountant book;
+    TriggerBook triggers;
+    // Written only under execMutex; atomic so readers never take the lock
+    std::atomic<double> cash;
+    double initialCash;
+    std::mutex execMutex;
+    std::atomic<int> tradeCount;
+    int winningTrades;
+    int losingTrades;
+    TradeJournal journal;
+    std::atomic<double> totalRealizedPnL;
+    AsyncLogger* logger;
+    WriteAheadJournal* wal;
+    const BookStore* depth;
+    uint64_t depthFills;      // fills priced by walking the book
+    uint64_t deepFills;       // of those, fills that went past the touch
+    uint64_t depthRejects;    // orders larger than the visible depth
+
+    // Prices a market order of quantity against the resting levels on side.
+    // A symbol whose book is still empty fills at the quoted price; one
+    // without enough visible depth for the whole order is not filled.
+    bool walkDepth(SymbolId symbol, BookSide side, int quantity, double& price) {
+        if (depth == nullptr) return true;
+        BookDepth levels;
+        depth->read(symbol, levels);
+        if (levels.levels[side] == 0) return true;
+        double avgPrice;
+        size_t used;
+        if (levels.sweep(side, quantity, avgPrice, used) < quantity) {
+            depthRejects++;
+            return false;
+        }
+        depthFills++;
+        if (used > 1) deepFills++;
+        price = avgPrice;
+        return true;
+    }
+
+    // Caller holds execMutex
+    void capture(EngineSnapshot& snapshot) {
+        snapshot.sequence = wal != nullptr ? wal->lastSequence() : 0;
+        snapshot.initialCapital = initialCash;
+        snapshot.cash = cash;
+        snapshot.realizedPnL = totalRealizedPnL;
+        snapshot.trades = static_cast<uint32_t>(tradeCount.load());
+        snapshot.wins = static_cast<uint32_t>(winningTrades);
+        snapshot.losses = static_cast<uint32_t>(losingTrades);
+        snapshot.positions.clear();
+        for (SymbolId id = 0; id < positions.size(); id++) {
+            if (positions[id].quantity == 0) continue;
+            SnapshotPosition p;
+            p.symbol = id;
+            p.quantity = positions[id].quantity;
+            p.totalCost = positions[id].totalCost;
+            p.mark = book.holding(id).mark;
+            triggers.save(id, p.triggers);
+            snapshot.positions.push_back(p);
+        }
+    }
+
+    // Caller holds execMutex. A full ring is rare (the commit thread
+    // checkpoints at half full), so the fill path writes the snapshot itself.
+    void journalFill(const Trade& trade, const PositionView& pos, double pnl, double stopLoss, double takeProfit) {
+        if (wal == nullptr) return;
+        if (!wal->hasRoom()) {
+            EngineSnapshot snapshot;
+            capture(snapshot);
+            wal->checkpoint(snapshot);
+        }
+        JournalRecord rec;
+        rec.type = trade.isBuy ? JOURNAL_BUY : JOURNAL_SELL;
+        rec.symbol = trade.symbol;
+        rec.strategy = trade.strategy;
+        rec.quantity = trade.quantity;
+        rec.position = pos.quantity;
+        rec.price = trade.price;
+        rec.positionCost = pos.totalCost;
+        rec.cash = cash;
+        rec.realizedPnL = totalRealizedPnL;
+        rec.pnl = pnl;
+        rec.stopLoss = stopLoss;
+        rec.takeProfit = takeProfit;
+        rec.timestamp = trade.timestamp;
+        wal->append(rec);
+    }
+
+    // Caller holds execMutex
+    void setPosition(SymbolId symbol, int quantity, double totalCost, double mark) {
+        PositionView& pos = positions[symbol];
+        pos.quantity = quantity;
+        pos.totalCost = quantity > 0 ? totalCost : 0;
+        pos.avgEntryPrice = quantity > 0 ? totalCost / quantity : 0;
+        book.update(symbol, pos.quantity, pos.totalCost, mark);
+    }
+
+    void logFill(LogEvent event, const Trade& trade, double amount) {
+        if (logger == nullptr || !logger->enabled(LOG_INFO)) return;
+        LogRecord rec;
+        rec.event = event;
+        rec.level = LOG_INFO;
+        rec.strategy = trade.strategy;
+        rec.symbol = trade.symbol;
+        rec.quantity = trade.quantity;
+        rec.price = trade.price;
+        rec.amount = amount;
+        rec.wallNanos = trade.timestamp;
+        rec.cycles = cycleCounter();
+        logger->log(rec);
+    }
+
+public:
+    TradingEngine(const SymbolTable& syms, double capital) : symbols(syms),
+        positions(syms.size()), book(syms.size()), triggers(syms.size()), cash(capital), initialCash(capital),
+        tradeCount(0), winningTrades(0),
+        losingTrades(0), totalRealizedPnL(0.0), logger(nullptr), wal(nullptr), depth(nullptr), depthFills(0),
+        deepFills(0), depthRejects(0) {
+    }
+
+    // Fills are reported through the logger; null disables fill logging
+    void setLogger(AsyncLogger* log) { logger = log; }
+
+    // Every fill is appended to this journal; null keeps state in memory only
+    void setJournal(WriteAheadJournal* journal) { wal = journal; }
+
+    // Snapshots the account and writes it beside the journal
+    bool checkpoint() {
+        if (wal == nullptr) return false;
+        EngineSnapshot snapshot;
+        {
+            std::lock_guard<std::mutex> lock(execMutex);
+            capture(snapshot);
+        }
+        return wal->checkpoint(snapshot);
+    }
+
+    // Startup, before any fill: rebuilds the account from the snapshot and
+    // the journal records after it; returns how many records were replayed
+    uint64_t recover(std::string& error) {
+        std::lock_guard<std::mutex> lock(execMutex);
+        EngineSnapshot snapshot;
+        if (wal->loadSnapshot(snapshot, error)) {
+            cash = snapshot.cash;
+            totalRealizedPnL = snapshot.realizedPnL;
+            tradeCount = static_cast<int>(snapshot.trades);
+            winningTrades = static_cast<int>(snapshot.wins);
+            losingTrades = static_cast<int>(snapshot.losses);
+            for (size_t i = 0; i < snapshot.positions.size(); i++) {
+                const SnapshotPosition& p = snapshot.positions[i];
+                if (p.symbol >= positions.size()) continue;
+                setPosition(p.symbol, p.quantity, p.totalCost, p.mark);
+                triggers.restore(p.symbol, p.triggers);
+            }
+        }
+        else if (!error.empty()) {
+            return 0;
+        }
+        return wal->replay(snapshot.sequence, [this](const JournalRecord& rec) {
+            cash = rec.cash;
+            totalRealizedPnL = rec.realizedPnL;
+            if (rec.type == JOURNAL_CAPITAL || rec.symbol >= positions.size()) return;
+            tradeCount++;
+            setPosition(rec.symbol, rec.position, rec.positionCost, rec.price);
+            if (rec.type == JOURNAL_BUY) {
+                triggers.arm(rec.symbol, rec.stopLoss, rec.takeProfit, rec.quantity);
+            }
+            else {
+                if (rec.pnl > 0) winningTrades++;
+                else losingTrades++;
+                if (rec.position == 0) triggers.clear(rec.symbol);
+            }
+        });
+    }
+
+    // Fills walk these books instead of filling in full at the quoted
+    // price; null keeps top-of-book fills
+    void setDepth(const BookStore* books) { depth = books; }
+
+    // Fills rest a stop and target for the new shares (non-positive skips a level)
+    bool executeBuy(SymbolId symbol, double price, int quantity, StrategyId strategy, int64_t timestamp,
+        double stopLoss, double takeProfit) {
+        HFT_PROFILE_SCOPE(PROFILE_EXECUTION);
+        std::lock_guard<std::mutex> lock(execMutex);
+        if (!walkDepth(symbol, BOOK_ASK, quantity, price)) return false;
+
+        double cost = price * quantity;
+        double commission = cost * COMMISSION_RATE;
+        double totalCost = cost + commission;
+
+        if (cash < totalCost) return false;
+
+        PositionView& pos = positions[symbol];
+
+        Trade trade;
+        trade.symbol = symbol;
+        trade.isBuy = true;
+        trade.price = price;
+        trade.quantity = quantity;
+        trade.timestamp = timestamp;
+        trade.strategy = strategy;
+
+        pos.totalCost += totalCost;
+        pos.quantity += quantity;
+        pos.avgEntryPrice = pos.totalCost / pos.quantity;
+        book.update(symbol, pos.quantity, pos.totalCost, price);
+        triggers.arm(symbol, stopLoss, takeProfit, quantity);
+
+        cash = cash - totalCost;
+        tradeCount++;
+        journal.append(trade);
+        journalFill(trade, pos, 0.0, stopLoss, takeProfit);
+
+        logFill(LOG_BUY, trade, totalCost);
+
+        return true;
+    }
+
+    // filledAt, when given, receives the price actually paid
+    bool executeSell(SymbolId symbol, double price, int quantity, StrategyId strategy, int64_t timestamp,
+        double* filledAt = nullptr) {
+        HFT_PROFILE_SCOPE(PROFILE_EXECUTION);
+        std::lock_guard<std::mutex> lock(execMutex);
+
+        PositionView& pos = positions[symbol];
+        if (pos.quantity < quantity) return false;
+        if (!walkDepth(symbol, BOOK_BID, quantity, price)) return false;
+        if (filledAt != nullptr) *filledAt = price;
+
+        double revenue = price * quantity;
+        double commission = revenue * COMMISSION_RATE;
+        double netRevenue = revenue - commission;
+
+        double costBasis = pos.avgEntryPrice * quantity;
+        double pnl = netRevenue - costBasis;
+
+        Trade trade;
+        trade.symbol = symbol;
+        trade.isBuy = false;
+        trade.price = price;
+        trade.quantity = quantity;
+        trade.timestamp = timestamp;
+        trade.strategy = strategy;
+
+        pos.quantity -= quantity;
+        if (pos.quantity > 0) {
+            pos.totalCost = pos.avgEntryPrice * pos.quantity;
+        }
+        else {
+            pos.totalCost = 0;
+            pos.avgEntryPrice = 0;
+            triggers.clear(symbol);
+        }
+        book.update(symbol, pos.quantity, pos.totalCost, price);
+
+        cash = cash + netRevenue;
+        totalRealizedPnL = totalRealizedPnL + pnl;
+        tradeCount++;
+        journal.append(trade);
+
+        if (pnl > 0) {
+            winningTrades++;
+        }
+        else {
+            losingTrades++;
+        }
+        journalFill(trade, pos, pnl, 0.0, 0.0);
+
+        logFill(LOG_SELL, trade, pnl);
+
+        return true;
+    }
+
+    PositionView getPosition(SymbolId symbol) {
+        std::lock_guard<std::mutex> lock(execMutex);
+        return positions[symbol];
+    }
+
+    // Chunks allocated by the fill journal so far (allocation accounting)
+    size_t getJournalChunks() {
+        std::lock_guard<std::mutex> lock(execMutex);
+        return journal.chunkCount();
+    }
+
+    // Called for every tick of a symbol so valuation tracks the market
+    void mark(SymbolId symbol, double price) {
+        book.mark(symbol, price);
+    }
+
+    // Tick path, O(1) and lock-free: has the bid crossed a resting exit level?
+    bool checkTriggers(SymbolId symbol, double bid, TriggerHit& hit) const {
+        return triggers.check(symbol, bid, hit);
+    }
+
+    void recordTriggeredExit(TriggerKind kind, double level, double fillPrice) {
+        std::lock_guard<std::mutex> lock(execMutex);
+        triggers.recordExit(kind, level, fillPrice);
+    }
+
+    void printExitReport() {
+        std::lock_guard<std::mutex> lock(execMutex);
+        triggers.printReport();
+    }
+
+    void printDepthReport() {
+        std::lock_guard<std::mutex> lock(execMutex);
+        if (depth == nullptr) return;
+        std::cout << Color::CYAN << "[BOOK] Fills priced from depth: " << depthFills
+            << " | Past the touch: " << deepFills << " | Rejected for depth: " << depthRejects
+            << " | Resting orders: " << depth->restingOrders()
+            << " | Levels dropped: " << depth->levelsDropped() << "\n" << Color::RESET;
+    }
+
+    // The readers below are O(1) and lock-free
+    double getCash() const { return cash; }
+
+    double getPortfolioValue() const {
+        return cash + book.getMarketValue();
+    }
+
+    double getUnrealizedPnL() const {
+        return book.getMarketValue() - book.getCostBasis();
+    }
+
+    double getRealizedPnL() const { return totalRealizedPnL; }
+
+    double getTotalPnL() const {
+        return getRealizedPnL() + getUnrealizedPnL();
+    }
+
+    int getTradeCount() const { return tradeCount; }
+    int getOpenPositions() const { return book.getOpenPositions(); }
+
+    int getWinningTrades() {
+        std::lock_guard<std::mutex> lock(execMutex);
+        return winningTrades;
+    }
+
+    int getLosingTrades() {
+        std::lock_guard<std::mutex> lock(execMutex);
+        return losingTrades;
+    }
+
+    // Values open positions at their last marks
+    void printSummary() {
+        std::lock_guard<std::mutex> lock(execMutex);
+
+        std::cout << "\n" << Color::BOLD << Color::CYAN;
+        std::cout << "============================================================\n";
+        std::cout << "                   TRADING SUMMARY                          \n";
+        std::cout << "============================================================\n";
+        std::cout << Color::RESET;
+
+        double portfolioValue = getPortfolioValue();
+        double unrealizedPnL = getUnrealizedPnL();
+        double totalPnL = totalRealizedPnL + unrealizedPnL;
+        double returnPct = (totalPnL / initialCash) * 100;
+
+        std::cout << Color::BOLD << "Initial Capital:      " << Color::RESET
+            << "$" << std::fixed << std::setprecision(2) << initialCash << "\n";
+        std::cout << Color::BOLD << "Final Portfolio Value:" << Color::RESET
+            << " $" << portfolioValue << "\n";
+        std::cout << Color::BOLD << "Cash Remaining:       " << Color::RESET
+            << "$" << cash << "\n\n";
+
+        std::cout << Color::BOLD << "Realized P&L:         " << Color::RESET;
+        if (totalRealizedPnL >= 0) {
+            std::cout << Color::GREEN << "+$" << totalRealizedPnL << Color::RESET;
+        }
+        else {
+            std::cout << Color::RED << "$" << totalRealizedPnL << Color::RESET;
+        }
+        std::cout << "\n";
+
+        std::cout << Color::BOLD << "Unrealized P&L:       " << Color::RESET;
+        if (unrealizedPnL >= 0) {
+            std::cout << Color::GREEN << "+$" << unrealizedPnL << Color::RESET;
+        }
+        else {
+            std::cout << Color::RED << "$" << unrealizedPnL << Color::RESET;
+        }
+        std::cout << "\n";
+
+        std::cout << Color::BOLD << "Total P&L:            " << Color::RESET;
+        if (totalPnL >= 0) {
+            std::cout << Color::GREEN << "+$" << totalPnL << " (+" << std::fixed << std::setprecision(2) << returnPct << "%)" << Color::RESET;
+        }
+        else {
+            std::cout << Color::RED << "$" << totalPnL << " (" << std::fixed << std::setprecision(2) << returnPct << "%)" << Color::RESET;
+        }
+        std::cout << "\n\n";
+
+        std::cout << Color::BOLD << "Total Trades:         " << Color::RESET << tradeCount << "\n";
+        std::cout << Color::BOLD << "Winning Trades:       " << Color::RESET
+            << Color::GREEN << winningTrades << Color::RESET << "\n";
+        std::cout << Color::BOLD << "Losing Trades:        " << Color::RESET
+            << Color::RED << losingTrades << Color::RESET << "\n";
+
+        if (winningTrades + losingTrades > 0) {
+            double winRate = (static_cast<double>(winningTrades) / (winningTrades + losingTrades)) * 100;
+            std::cout << Color::BOLD << "Win Rate:             " << Color::RESET
+                << std::setprecision(1) << winRate << "%\n";
+        }
+
+        int openPos = book.getOpenPositions();
+
+        if (openPos > 0) {
+            std::cout << "\n" << Color::BOLD << Color::YELLOW << "Open Positions: " << openPos << "\n" << Color::RESET;
+            for (SymbolId id = 0; id < positions.size(); id++) {
+                const PositionView& pos = positions[id];
+                double currentPrice = book.holding(id).mark;
+                if (pos.quantity > 0 && currentPrice > 0) {
+                    double posUnrealized = (currentPrice - pos.avgEntryPrice) * pos.quantity;
+                    std::string posColor = (posUnrealized >= 0) ? Color::GREEN : Color::RED;
+
+                    std::cout << "  " << symbols.name(id) << ": " << pos.quantity
+                        << " @ $" << std::setprecision(2) << pos.avgEntryPrice
+                        << " (Current: $" << currentPrice << ") "
+                        << posColor << "$" << posUnrealized << Color::RESET << "\n";
+                }
+            }
+        }
+        std::cout << "\n";
+    }
+};
+
+// Everything the strategies read for one tick, gathered once and shared
+struct TickContext {
+    const MarketData& quote;
+    const Indicators& ind;
+    size_t history;  // prices in the window
+    double mid;
+    double trend;    // change over the last 5 prices; 0 below 5 prices
+
+    TickContext(const MarketData& current, const PriceWindow& prices, const Indicators& indicators)
+        : quote(current), ind(indicators), history(prices.size()), mid(current.mid()),
+        trend(prices.size() >= 5
+            ? (prices[prices.size() - 1] - prices[prices.size() - 5]) / prices[prices.size() - 5] : 0.0) {
+    }
+};
+
+inline Signal noSignal() {
+    Signal sig;
+    sig.action = Signal::NONE;
+    sig.confidence = 0.0;
+    sig.stopLoss = 0.0;
+    sig.takeProfit = 0.0;
+    return sig;
+}
+
+// Strategy thresholds. Rules take these as template parameters so every
+// comparison folds to an immediate; a tuned variant is just another struct.
+struct MeanRevParams {
+    static constexpr size_t MIN_SAMPLES = STATS_PERIOD;
+    static constexpr double MIN_STDEV = 0.01;
+    static constexpr double Z_ENTRY = 1.8;
+    static constexpr double MAX_TREND = 0.012;     // against the entry direction
+    static constexpr double MAX_VOLATILITY = 0.04; // stdev / mean
+    static constexpr double CONFIDENCE = 0.85;
+    static constexpr double LONG_STOP = 0.985;
+    static constexpr double SHORT_STOP = 1.015;
+};
+
+struct TrendFollowParams {
+    static constexpr size_t MIN_SAMPLES = LONG_MA_PERIOD;
+    static constexpr double MIN_MOMENTUM = 0.003;  // (shortMA - longMA) / longMA
+    static constexpr double CONFIDENCE = 0.84;
+    static constexpr double LONG_TARGET = 1.015;
+    static constexpr double LONG_STOP = 0.992;
+    static constexpr double SHORT_TARGET = 0.985;
+    static constexpr double SHORT_STOP = 1.008;
+};
+
+struct BreakoutParams {
+    static constexpr size_t MIN_SAMPLES = BREAKOUT_PERIOD;
+    static constexpr double MIN_RANGE = 0.015;          // prior range / band edge
+    static constexpr double MAX_CONSOLIDATION = 0.65;   // recent range / prior range
+    static constexpr double CONFIDENCE = 0.81;
+    static constexpr double LONG_TARGET = 1.02;
+    static constexpr double LONG_STOP = 0.996;
+    static constexpr double SHORT_TARGET = 0.98;
+    static constexpr double SHORT_STOP = 1.004;
+};
+
+// Runtime copies of the thresholds for tuning without a rebuild. Fields are
+// named like the Params constants, so a rule's evaluate() reads either kind.
+struct MeanRevTuning {
+    size_t MIN_SAMPLES = MeanRevParams::MIN_SAMPLES;
+    double MIN_STDEV = MeanRevParams::MIN_STDEV;
+    double Z_ENTRY = MeanRevParams::Z_ENTRY;
+    double MAX_TREND = MeanRevParams::MAX_TREND;
+    double MAX_VOLATILITY = MeanRevParams::MAX_VOLATILITY;
+    double CONFIDENCE = MeanRevParams::CONFIDENCE;
+    double LONG_STOP = MeanRevParams::LONG_STOP;
+    double SHORT_STOP = MeanRevParams::SHORT_STOP;
+};
+
+struct TrendFollowTuning {
+    size_t MIN_SAMPLES = TrendFollowParams::MIN_SAMPLES;
+    double MIN_MOMENTUM = TrendFollowParams::MIN_MOMENTUM;
+    double CONFIDENCE = TrendFollowParams::CONFIDENCE;
+    double LONG_TARGET = TrendFollowParams::LONG_TARGET;
+    double LONG_STOP = TrendFollowParams::LONG_STOP;
+    double SHORT_TARGET = TrendFollowParams::SHORT_TARGET;
+    double SHORT_STOP = TrendFollowParams::SHORT_STOP;
+};
+
+struct BreakoutTuning {
+    size_t MIN_SAMPLES = BreakoutParams::MIN_SAMPLES;
+    double MIN_RANGE = BreakoutParams::MIN_RANGE;
+    double MAX_CONSOLIDATION = BreakoutParams::MAX_CONSOLIDATION;
+    double CONFIDENCE = BreakoutParams::CONFIDENCE;
+    double LONG_TARGET = BreakoutParams::LONG_TARGET;
+    double LONG_STOP = BreakoutParams::LONG_STOP;
+    double SHORT_TARGET = BreakoutParams::SHORT_TARGET;
+    double SHORT_STOP = BreakoutParams::SHORT_STOP;
+};
+
+// Outer bounds on every bracket, relative to the entry cost
+const double STOP_LOSS_PCT = 0.018;
+const double TAKE_PROFIT_PCT = 0.022;
+const double POSITION_FRACTION = 0.02;  // of available cash per entry
+const double MIN_ENTRY_CONFIDENCE = 0.80;
+
+// Sizing and exit limits applied by StrategyRunner to every entry
+struct TradeTuning {
+    double positionFraction = POSITION_FRACTION;
+    double stopLossPct = STOP_LOSS_PCT;
+    double takeProfitPct = TAKE_PROFIT_PCT;
+    bool passiveEntries = false;  // join the bid instead of lifting the offer
+};
+
+// Everything --tune and --sweep-axis can set. With customThresholds unset
+// the built-in rules keep running on their compile-time Params.
+struct StrategyTuning {
+    MeanRevTuning meanRev;
+    TrendFollowTuning trend;
+    BreakoutTuning breakout;
+    TradeTuning trade;
+    bool customThresholds = false;
+};
+
+// A named, settable field of StrategyTuning
+struct TuningField {
+    const char* name;
+    bool threshold;  // false for the TradeTuning fields, which never need the virtual path
+    double& (*field)(StrategyTuning&);
+};
+
+const TuningField TUNING_FIELDS[] = {
+    { "meanrev.z_entry", true, [](StrategyTuning& t) -> double& { return t.meanRev.Z_ENTRY; } },
+    { "meanrev.max_trend", true, [](StrategyTuning& t) -> double& { return t.meanRev.MAX_TREND; } },
+    { "meanrev.max_volatility", true, [](StrategyTuning& t) -> double& { return t.meanRev.MAX_VOLATILITY; } },
+    { "meanrev.long_stop", true, [](StrategyTuning& t) -> double& { return t.meanRev.LONG_STOP; } },
+    { "trend.min_momentum", true, [](StrategyTuning& t) -> double& { return t.trend.MIN_MOMENTUM; } },
+    { "trend.long_target", true, [](StrategyTuning& t) -> double& { return t.trend.LONG_TARGET; } },
+    { "trend.long_stop", true, [](StrategyTuning& t) -> double& { return t.trend.LONG_STOP; } },
+    { "breakout.min_range", true, [](StrategyTuning& t) -> double& { return t.breakout.MIN_RANGE; } },
+    { "breakout.max_consolidation", true, [](StrategyTuning& t) -> double& { return t.breakout.MAX_CONSOLIDATION; } },
+    { "breakout.long_target", true, [](StrategyTuning& t) -> double& { return t.breakout.LONG_TARGET; } },
+    { "exit.stop_loss", false, [](StrategyTuning& t) -> double& { return t.trade.stopLossPct; } },
+    { "exit.take_profit", false, [](StrategyTuning& t) -> double& { return t.trade.takeProfitPct; } },
+    { "size.fraction", false, [](StrategyTuning& t) -> double& { return t.trade.positionFraction; } },
+};
+
+const TuningField* findTuningField(const std::string& name) {
+    for (const TuningField& f : TUNING_FIELDS) {
+        if (name == f.name) return &f;
+    }
+    return nullptr;
+}
+
+void setTuning(StrategyTuning& tuning, const TuningField& field, double value) {
+    field.field(tuning) = value;
+    if (field.threshold) tuning.customThresholds = true;
+}
+
+std::string tuningFieldNames() {
+    std::string names;
+    for (const TuningField& f : TUNING_FIELDS) {
+        if (!names.empty()) names += ", ";
+        names += f.name;
+    }
+    return names;
+}
+
+// A rule provides NAME, evaluate() for one tick and analyzeAll() for the
+// batch path. evaluate() also accepts a runtime Tuning in place of P; the
+// kernels are only instantiated for the constexpr Params. Both must agree
+// bit for bit, so the AVX2 kernels use the same IEEE predicates as
+// evaluate(), including the NaN cases.
+template <typename P = MeanRevParams>
+struct MeanReversionRule {
+    static constexpr const char* NAME = "MeanRev";
+
+    static Signal evaluate(const TickContext& t, const P& p = P()) {
+        Signal sig = noSignal();
+        if (t.ind.samples < p.MIN_SAMPLES || t.history < 5) return sig;
+
+        double mean = t.ind.mean;
+        double stdev = t.ind.stdev;
+        if (stdev < p.MIN_STDEV) return sig;
+
+        double zscore = (t.mid - mean) / stdev;
+
+        // The short-term trend check avoids catching falling knives
+        if (zscore < -p.Z_ENTRY && t.trend > -p.MAX_TREND && stdev / mean < p.MAX_VOLATILITY) {
+            sig.action = Signal::BUY;
+            sig.confidence = p.CONFIDENCE;
+            sig.takeProfit = mean;
+            sig.stopLoss = t.mid * p.LONG_STOP;
+        }
+        else if (zscore > p.Z_ENTRY && t.trend < p.MAX_TREND && stdev / mean < p.MAX_VOLATILITY) {
+            sig.action = Signal::SELL;
+            sig.confidence = p.CONFIDENCE;
+            sig.takeProfit = mean;
+            sig.stopLoss = t.mid * p.SHORT_STOP;
+        }
+        return sig;
+    }
+
+    static void scalarKernel(const UniverseFrame& f, size_t begin, SignalMask& buys, SignalMask& sells) {
+        for (size_t i = begin; i < f.count; i++) {
+            if (f.samples[i] < P::MIN_SAMPLES || f.history[i] < 5 || f.stdev[i] < P::MIN_STDEV) continue;
+            double zscore = (f.mid[i] - f.mean[i]) / f.stdev[i];
+            bool calm = f.stdev[i] / f.mean[i] < P::MAX_VOLATILITY;
+            if (zscore < -P::Z_ENTRY && f.trend[i] > -P::MAX_TREND && calm) buys.set(i);
+            else if (zscore > P::Z_ENTRY && f.trend[i] < P::MAX_TREND && calm) sells.set(i);
+        }
+    }
+
+#ifdef HFT_HAS_AVX2_KERNELS
+    HFT_TARGET_AVX2 static size_t avx2Kernel(const UniverseFrame& f, SignalMask& buys, SignalMask& sells) {
+        const __m256d minSamples = _mm256_set1_pd(static_cast<double>(P::MIN_SAMPLES));
+        const __m256d minHistory = _mm256_set1_pd(5.0);
+        const __m256d minStdev = _mm256_set1_pd(P::MIN_STDEV);
+        size_t i = 0;
+        for (; i + 4 <= f.count; i += 4) {
+            __m256d stdev = _mm256_loadu_pd(&f.stdev[i]);
+            __m256d mean = _mm256_loadu_pd(&f.mean[i]);
+            __m256d trend = _mm256_loadu_pd(&f.trend[i]);
+            __m256d valid = _mm256_and_pd(
+                _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(&f.samples[i]), minSamples, _CMP_NLT_UQ),
+                    _mm256_cmp_pd(_mm256_loadu_pd(&f.history[i]), minHistory, _CMP_NLT_UQ)),
+                _mm256_cmp_pd(stdev, minStdev, _CMP_NLT_UQ));
+            __m256d zscore = _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(&f.mid[i]), mean), stdev);
+            __m256d calm = _mm256_cmp_pd(_mm256_div_pd(stdev, mean), _mm256_set1_pd(P::MAX_VOLATILITY), _CMP_LT_OQ);
+            __m256d base = _mm256_and_pd(valid, calm);
+            __m256d buy = _mm256_and_pd(base, _mm256_and_pd(
+                _mm256_cmp_pd(zscore, _mm256_set1_pd(-P::Z_ENTRY), _CMP_LT_OQ),
+                _mm256_cmp_pd(trend, _mm256_set1_pd(-P::MAX_TREND), _CMP_GT_OQ)));
+            __m256d sell = _mm256_andnot_pd(buy, _mm256_and_pd(base, _mm256_and_pd(
+                _mm256_cmp_pd(zscore, _mm256_set1_pd(P::Z_ENTRY), _CMP_GT_OQ),
+                _mm256_cmp_pd(trend, _mm256_set1_pd(P::MAX_TREND), _CMP_LT_OQ))));
+            buys.setBits(i, static_cast<uint64_t>(_mm256_movemask_pd(buy)));
+            sells.setBits(i, static_cast<uint64_t>(_mm256_movemask_pd(sell)));
+        }
+        return i;
+    }
+#endif
+
+    static void analyzeAll(const UniverseFrame& frame, KernelIsa isa, SignalMask& buys, SignalMask& sells) {
+        size_t done = 0;
+#ifdef HFT_HAS_AVX2_KERNELS
+        if (isa == KernelIsa::Avx2) done = avx2Kernel(frame, buys, sells);
+#endif
+        scalarKernel(frame, done, buys, sells);
+    }
+};
+
+template <typename P = TrendFollowParams>
+struct TrendFollowingRule {
+    static constexpr const char* NAME = "TrendFollow";
+
+    static Signal evaluate(const TickContext& t, const P& p = P()) {
+        Signal sig = noSignal();
+        if (t.ind.samples < p.MIN_SAMPLES || t.history < 5) return sig;
+
+        double shortMA = t.ind.shortMA;
+        double longMA = t.ind.longMA;
+        double prevShortMA = t.ind.prevShortMA;
+
+        bool crossedUp = (prevShortMA <= longMA && shortMA > longMA);
+        bool crossedDown = (prevShortMA >= longMA && shortMA < longMA);
+        double momentum = (shortMA - longMA) / longMA;
+
+        if (crossedUp && momentum > p.MIN_MOMENTUM && t.trend > 0) {
+            sig.action = Signal::BUY;
+            sig.confidence = p.CONFIDENCE;
+            sig.takeProfit = t.mid * p.LONG_TARGET;
+            sig.stopLoss = t.mid * p.LONG_STOP;
+        }
+        else if (crossedDown && momentum < -p.MIN_MOMENTUM && t.trend < 0) {
+            sig.action = Signal::SELL;
+            sig.confidence = p.CONFIDENCE;
+            sig.takeProfit = t.mid * p.SHORT_TARGET;
+            sig.stopLoss = t.mid * p.SHORT_STOP;
+        }
+        return sig;
+    }
+
+    static void scalarKernel(const UniverseFrame& f, size_t begin, SignalMask& buys, SignalMask& sells) {
+        for (size_t i = begin; i < f.count; i++) {
+            if (f.samples[i] < P::MIN_SAMPLES || f.history[i] < 5) continue;
+            double shortMA = f.shortMA[i], longMA = f.longMA[i], prevShortMA = f.prevShortMA[i];
+            bool crossedUp = (prevShortMA <= longMA && shortMA > longMA);
+            bool crossedDown = (prevShortMA >= longMA && shortMA < longMA);
+            double momentum = (shortMA - longMA) / longMA;
+            if (crossedUp && momentum > P::MIN_MOMENTUM && f.trend[i] > 0) buys.set(i);
+            else if (crossedDown && momentum < -P::MIN_MOMENTUM && f.trend[i] < 0) sells.set(i);
+        }
+    }
+
+#ifdef HFT_HAS_AVX2_KERNELS
+    HFT_TARGET_AVX2 static size_t avx2Kernel(const UniverseFrame& f, SignalMask& buys, SignalMask& sells) {
+        const __m256d zero = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= f.count; i += 4) {
+            __m256d valid = _mm256_and_pd(
+                _mm256_cmp_pd(_mm256_loadu_pd(&f.samples[i]), _mm256_set1_pd(static_cast<double>(P::MIN_SAMPLES)), _CMP_NLT_UQ),
+                _mm256_cmp_pd(_mm256_loadu_pd(&f.history[i]), _mm256_set1_pd(5.0), _CMP_NLT_UQ));
+            __m256d shortMA = _mm256_loadu_pd(&f.shortMA[i]);
+            __m256d longMA = _mm256_loadu_pd(&f.longMA[i]);
+            __m256d prevShortMA = _mm256_loadu_pd(&f.prevShortMA[i]);
+            __m256d trend = _mm256_loadu_pd(&f.trend[i]);
+            __m256d momentum = _mm256_div_pd(_mm256_sub_pd(shortMA, longMA), longMA);
+            __m256d crossedUp = _mm256_and_pd(_mm256_cmp_pd(prevShortMA, longMA, _CMP_LE_OQ),
+                _mm256_cmp_pd(shortMA, longMA, _CMP_GT_OQ));
+            __m256d crossedDown = _mm256_and_pd(_mm256_cmp_pd(prevShortMA, longMA, _CMP_GE_OQ),
+                _mm256_cmp_pd(shortMA, longMA, _CMP_LT_OQ));
+            __m256d buy = _mm256_and_pd(_mm256_and_pd(valid, crossedUp), _mm256_and_pd(
+                _mm256_cmp_pd(momentum, _mm256_set1_pd(P::MIN_MOMENTUM), _CMP_GT_OQ),
+                _mm256_cmp_pd(trend, zero, _CMP_GT_OQ)));
+            __m256d sell = _mm256_andnot_pd(buy, _mm256_and_pd(_mm256_and_pd(valid, crossedDown), _mm256_and_pd(
+                _mm256_cmp_pd(momentum, _mm256_set1_pd(-P::MIN_MOMENTUM), _CMP_LT_OQ),
+                _mm256_cmp_pd(trend, zero, _CMP_LT_OQ))));
+            buys.setBits(i, static_cast<uint64_t>(_mm256_movemask_pd(buy)));
+            sells.setBits(i, static_cast<uint64_t>(_mm256_movemask_pd(sell)));
+        }
+        return i;
+    }
+#endif
+
+    static void analyzeAll(const UniverseFrame& frame, KernelIsa isa, SignalMask& buys, SignalMask& sells) {
+        size_t done = 0;
+#ifdef HFT_HAS_AVX2_KERNELS
+        if (isa == KernelIsa::Avx2) done = avx2Kernel(frame, buys, sells);
+#endif
+        scalarKernel(frame, done, buys, sells);
+    }
+};
+
+template <typename P = BreakoutParams>
+struct BreakoutRule {
+    static constexpr const char* NAME = "Breakout";
+
+    static Signal evaluate(const TickContext& t, const P& p = P()) {
+        Signal sig = noSignal();
+        if (t.ind.samples < p.MIN_SAMPLES) return sig;
+
+        double high = t.ind.priorHigh;
+        double low = t.ind.priorLow;
+        double range = high - low;
+
+        // Only trade significant breakouts that follow a consolidation
+        double recentRange = t.ind.recentHigh - t.ind.recentLow;
+
+        if (t.mid > high && range / high > p.MIN_RANGE && recentRange / range < p.MAX_CONSOLIDATION) {
+            sig.action = Signal::BUY;
+            sig.confidence = p.CONFIDENCE;
+            sig.takeProfit = t.mid * p.LONG_TARGET;
+            sig.stopLoss = high * p.LONG_STOP;
+        }
+        else if (t.mid < low && range / low > p.MIN_RANGE && recentRange / range < p.MAX_CONSOLIDATION) {
+            sig.action = Signal::SELL;
+            sig.confidence = p.CONFIDENCE;
+            sig.takeProfit = t.mid * p.SHORT_TARGET;
+            sig.stopLoss = low * p.SHORT_STOP;
+        }
+        return sig;
+    }
+
+    static void scalarKernel(const UniverseFrame& f, size_t begin, SignalMask& buys, SignalMask& sells) {
+        for (size_t i = begin; i < f.count; i++) {
+            if (f.samples[i] < P::MIN_SAMPLES) continue;
+            double high = f.priorHigh[i], low = f.priorLow[i];
+            double range = high - low;
+            bool consolidated = (f.recentHigh[i] - f.recentLow[i]) / range < P::MAX_CONSOLIDATION;
+            if (f.mid[i] > high && range / high > P::MIN_RANGE && consolidated) buys.set(i);
+            else if (f.mid[i] < low && range / low > P::MIN_RANGE && consolidated) sells.set(i);
+        }
+    }
+
+#ifdef HFT_HAS_AVX2_KERNELS
+    HFT_TARGET_AVX2 static size_t avx2Kernel(const UniverseFrame& f, SignalMask& buys, SignalMask& sells) {
+        const __m256d minRange = _mm256_set1_pd(P::MIN_RANGE);
+        size_t i = 0;
+        for (; i + 4 <= f.count; i += 4) {
+            __m256d valid = _mm256_cmp_pd(_mm256_loadu_pd(&f.samples[i]),
+                _mm256_set1_pd(static_cast<double>(P::MIN_SAMPLES)), _CMP_NLT_UQ);
+            __m256d high = _mm256_loadu_pd(&f.priorHigh[i]);
+            __m256d low = _mm256_loadu_pd(&f.priorLow[i]);
+            __m256d mid = _mm256_loadu_pd(&f.mid[i]);
+            __m256d range = _mm256_sub_pd(high, low);
+            __m256d recentRange = _mm256_sub_pd(_mm256_loadu_pd(&f.recentHigh[i]), _mm256_loadu_pd(&f.recentLow[i]));
+            __m256d base = _mm256_and_pd(valid, _mm256_cmp_pd(_mm256_div_pd(recentRange, range),
+                _mm256_set1_pd(P::MAX_CONSOLIDATION), _CMP_LT_OQ));
+            __m256d buy = _mm256_and_pd(base, _mm256_and_pd(_mm256_cmp_pd(mid, high, _CMP_GT_OQ),
+                _mm256_cmp_pd(_mm256_div_pd(range, high), minRange, _CMP_GT_OQ)));
+            __m256d sell = _mm256_andnot_pd(buy, _mm256_and_pd(base, _mm256_and_pd(_mm256_cmp_pd(mid, low, _CMP_LT_OQ),
+                _mm256_cmp_pd(_mm256_div_pd(range, low), minRange, _CMP_GT_OQ))));
+            buys.setBits(i, static_cast<uint64_t>(_mm256_movemask_pd(buy)));
+            sells.setBits(i, static_cast<uint64_t>(_mm256_movemask_pd(sell)));
+        }
+        return i;
+    }
+#endif
+
+    static void analyzeAll(const UniverseFrame& frame, KernelIsa isa, SignalMask& buys, SignalMask& sells) {
+        size_t done = 0;
+#ifdef HFT_HAS_AVX2_KERNELS
+        if (isa == KernelIsa::Avx2) done = avx2Kernel(frame, buys, sells);
+#endif
+        scalarKernel(frame, done, buys, sells);
+    }
+};
+
+// Compile-time strategy pipeline: every rule is called directly, so the
+// compiler inlines them all into one pass over a shared TickContext
+template <typename... Rules>
+struct StrategySet {
+    static constexpr size_t SIZE = sizeof...(Rules);
+
+#ifdef HFT_PROFILE
+    template <typename Rule>
+    static void profiledEvaluate(const TickContext& t, Signal& out, size_t j) {
+        HFT_PROFILE_STRATEGY(j);
+        out = Rule::evaluate(t);
+    }
+#endif
+
+    // out[j] receives rule j's signal. A profile build times each rule on
+    // its own, which keeps the compiler from fusing them into one pass.
+    static void evaluate(const TickContext& t, Signal* out) {
+        size_t j = 0;
+#ifdef HFT_PROFILE
+        ((profiledEvaluate<Rules>(t, out[j], j), j++), ...);
+#else
+        ((out[j++] = Rules::evaluate(t)), ...);
+#endif
+    }
+
+    static void analyzeAll(const UniverseFrame& frame, KernelIsa isa, SignalMask* buys, SignalMask* sells) {
+        size_t j = 0;
+        ((Rules::analyzeAll(frame, isa, buys[j], sells[j]), j++), ...);
+    }
+
+    static void appendNames(std::vector<std::string>& names) {
+        (names.push_back(Rules::NAME), ...);
+    }
+};
+
+using BuiltinStrategies = StrategySet<MeanReversionRule<>, TrendFollowingRule<>, BreakoutRule<>>;
+
+// Runtime-polymorphic strategy interface, for strategies that are not
+// known at compile time (plugins)
+class TradingStrategy {
+protected:
+    std::string name;
+
+public:
+    TradingStrategy(const std::string& n) : name(n) {}
+    virtual Signal analyze(SymbolId symbol, const PriceWindow& prices,
+        const MarketData& current, const Indicators& ind) = 0;
+
+    // Batch path: sets the bit of every symbol for which analyze() would
+    // return BUY or SELL. Returns false if the strategy has no batch kernel.
+    virtual bool analyzeAll(const UniverseFrame&, KernelIsa, SignalMask&, SignalMask&) const {
+        return false;
+    }
+
+    std::string getName() const { return name; }
+    virtual ~TradingStrategy() {}
+};
+
+// Exposes a compile-time rule through the virtual interface
+template <typename Rule>
+class RuleStrategy : public TradingStrategy {
+public:
+    RuleStrategy() : TradingStrategy(Rule::NAME) {}
+
+    Signal analyze(SymbolId, const PriceWindow& prices,
+        const MarketData& current, const Indicators& ind) override {
+        return Rule::evaluate(TickContext(current, prices, ind));
+    }
+
+    bool analyzeAll(const UniverseFrame& frame, KernelIsa isa,
+        SignalMask& buys, SignalMask& sells) const override {
+        Rule::analyzeAll(frame, isa, buys, sells);
+        return true;
+    }
+};
+
+using ImprovedMeanReversionStrategy = RuleStrategy<MeanReversionRule<>>;
+using TrendFollowingStrategy = RuleStrategy<TrendFollowingRule<>>;
+using BreakoutStrategy = RuleStrategy<BreakoutRule<>>;
+
+// A rule driven by runtime thresholds; no batch kernel, so the batch path
+// falls back to analyze() for every symbol
+template <template <typename> class Rule, typename Tuning>
+class TunedRuleStrategy : public TradingStrategy {
+private:
+    Tuning params;
+
+public:
+    explicit TunedRuleStrategy(const Tuning& tuning) : TradingStrategy(Rule<Tuning>::NAME), params(tuning) {}
+
+    Signal analyze(SymbolId, const PriceWindow& prices,
+        const MarketData& current, const Indicators& ind) override {
+        return Rule<Tuning>::evaluate(TickContext(current, prices, ind), params);
+    }
+};
+
+// Large enough to absorb every tick published during warm-up
+const size_t TICK_QUEUE_CAPACITY = 65536;
+const size_t ORDER_QUEUE_CAPACITY = 1024;
+const int MAX_OPEN_POSITIONS = 25;
+
+// Pre-trade limits; a zero disables the corresponding check
+struct RiskLimits {
+    int maxOpenPositions;
+    double maxOrderNotional;  // per symbol, dollars per order
+    int maxOrdersPerSecond;   // entries per second of market time
+    double maxDrawdown;       // fraction below peak portfolio value that halts entries
+
+    RiskLimits() : maxOpenPositions(MAX_OPEN_POSITIONS), maxOrderNotional(0.0),
+        maxOrdersPerSecond(1000), maxDrawdown(0.25) {
+    }
+};
+
+// CPUs for each thread role; -1 or an empty list leaves threads to the OS
+struct ThreadPlacement {
+    int feedCpu;
+    std::vector<int> tradingCpus;  // shard i takes entry i and the sequencer the next, round-robin
+    int housekeepingCpu;           // display, logger and the main thread
+    bool realtime;                 // SCHED_FIFO for the pinned feed and trading threads
+    bool numaLocal;                // first-touch hot-path state on the first trading CPU's node
+    bool autoAssign;               // resolved against the core count once the shard count is known
+
+    ThreadPlacement() : feedCpu(-1), housekeepingCpu(-1), realtime(false), numaLocal(false), autoAssign(false) {}
+
+    int tradingCpu(size_t slot) const {
+        return tradingCpus.empty() ? -1 : tradingCpus[slot % tradingCpus.size()];
+    }
+
+    bool enabled() const {
+        return feedCpu >= 0 || !tradingCpus.empty() || housekeepingCpu >= 0 || realtime;
+    }
+};
+
+// Housekeeping on cpu 0, the feed on cpu 1, then one CPU per shard and one
+// for the sequencer. Returns false if the machine has too few cores.
+bool resolveAutoPlacement(ThreadPlacement& placement, size_t shardCount) {
+    size_t needed = shardCount + 3;
+    if (std::thread::hardware_concurrency() < needed) return false;
+    placement.housekeepingCpu = 0;
+    placement.feedCpu = 1;
+    placement.tradingCpus.clear();
+    for (size_t i = 0; i <= shardCount; i++) placement.tradingCpus.push_back(static_cast<int>(i + 2));
+    return true;
+}
+
+// Pins one thread and sets its priority. Hot-path threads only go realtime
+// once pinned, so a spinning shard can never starve a shared core; with any
+// placement requested, housekeeping threads run at background priority.
+// Returns false if a request failed; line always describes the outcome.
+bool placeThread(const std::string& role, ThreadHandle handle, int cpu, bool hotPath,
+    const ThreadPlacement& placement, std::string& line) {
+    std::string failures;
+    std::string error;
+    bool pinned = false;
+    if (cpu >= 0) {
+        pinned = pinThread(handle, cpu, error);
+        if (!pinned) failures += "pin to cpu " + std::to_string(cpu) + " failed: " + error + "; ";
+    }
+    // Set explicitly either way: new threads inherit the policy of a demoted creator
+    if (hotPath) {
+        bool realtime = placement.realtime && pinned;
+        if (!setThreadPriority(handle, realtime ? ThreadPriority::Realtime : ThreadPriority::Normal, error)) {
+            failures += std::string(realtime ? "SCHED_FIFO" : "normal priority") + " refused: " + error + "; ";
+        }
+    }
+    else {
+        if (!setThreadPriority(handle, ThreadPriority::Background, error)) {
+            failures += "demotion refused: " + error + "; ";
+        }
+    }
+    line = role + " -> " + failures + describeThread(handle);
+    return failures.empty();
+}
+
+// Simulated venue behaviour; the defaults fill every order at once, in full
+const int64_t DEFAULT_REST_TIMEOUT_NANOS = 20 * TICK_INTERVAL_NANOS;
+const double DEFAULT_TOUCH_TURNOVER = 0.25;
+
+enum class GatewayModel { Simple, Matching };
+
+bool parseGatewayModel(const std::string& text, GatewayModel& model) {
+    if (text == "simple") model = GatewayModel::Simple;
+    else if (text == "match") model = GatewayModel::Matching;
+    else return false;
+    return true;
+}
+
+struct GatewayConfig {
+    GatewayModel model;
+    int64_t latencyNanos;  // send to ack, and between successive fills; the round trip when matching
+    int slices;            // fills per order (simple model)
+    double collarBps;      // reject once the touch moves this far against the order; 0 disables
+    // Matching model only
+    int64_t jitterNanos;       // mean of the exponential delay added to each one-way message
+    int64_t restTimeoutNanos;  // passive orders still resting after this are cancelled
+    double touchTurnover;      // largest share of the touch that trades per quote
+
+    GatewayConfig()
+        : model(GatewayModel::Simple), latencyNanos(0), slices(1), collarBps(0), jitterNanos(0),
+        restTimeoutNanos(DEFAULT_REST_TIMEOUT_NANOS), touchTurnover(DEFAULT_TOUCH_TURNOVER) {}
+};
+
+const uint64_t MAX_LATENCY_DUMP_SECONDS = 86400;
+
+struct SystemConfig {
+    double capital;
+    WaitPolicy waitPolicy;
+    int latencyDumpSeconds;
+    size_t historyWindow;
+    size_t shardCount;
+    LogLevel logLevel;
+    std::string logFile;  // empty logs to the console
+    uint32_t seed;        // 0 seeds the live feed from std::random_device
+    uint64_t backtestSteps;
+    std::string recordFile;  // empty disables tick recording
+    std::string replayFile;  // empty uses the simulator
+    double replaySpeed;      // live replay pacing multiple; 0 replays flat out
+    RiskLimits risk;
+    bool batchSignals;       // backtest: evaluate strategies once per timestamp across all symbols
+    bool allowSimd;          // false forces the scalar batch kernels
+    bool virtualStrategies;  // run the built-in strategies through TradingStrategy
+    FeedGenerator generator;
+    int64_t tickIntervalNanos;  // simulated step spacing; 0 runs the live feed flat out
+    std::string universeFile;   // one symbol per line; takes precedence over universeSize
+    size_t universeSize;        // SYM00001..N; 0 with no file trades ALL_STOCKS
+    ThreadPlacement placement;
+    StrategyTuning tuning;
+    std::string feedUrl;        // udp:// or tcp:// binary feed; empty uses replay or the simulator
+    bool orderBooks;            // keep per-symbol books and price fills by walking them
+    size_t bookLevels;          // synthetic levels per side laid around each quote
+    GatewayConfig gateway;
+    std::string metricsAddress;  // [HOST:]PORT for the Prometheus endpoint; empty disables it
+    std::string journalFile;     // write-ahead fill journal; empty keeps the account in memory only
+    size_t journalRecords;       // ring size when the journal is created
+    std::vector<double> accountWeights;  // capital split across sub-accounts; empty trades one account
+    bool headless;               // no prompts or console status line; a signal ends the session
+    std::string warmStartFile;   // tick recording that seeds history before trading starts
+
+    SystemConfig() : capital(0), waitPolicy(WaitPolicy::Hybrid), latencyDumpSeconds(0),
+        historyWindow(DEFAULT_HISTORY_WINDOW), shardCount(defaultShardCount()), logLevel(LOG_INFO),
+        seed(0), backtestSteps(0), replaySpeed(1.0), batchSignals(false), allowSimd(true),
+        virtualStrategies(false), generator(FeedGenerator::Classic), tickIntervalNanos(TICK_INTERVAL_NANOS),
+        universeSize(0), orderBooks(false), bookLevels(DEFAULT_BOOK_LEVELS), journalRecords(DEFAULT_JOURNAL_RECORDS),
+        headless(false) {
+    }
+
+    static size_t defaultShardCount() {
+        size_t cores = std::thread::hardware_concurrency();
+        return std::max<size_t>(1, std::min<size_t>(4, cores / 2));
+    }
+};
+
+// The traded universe is fixed for the life of the process: every
+// component sizes its per-symbol arrays from the one SymbolTable built here
+bool loadUniverse(const SystemConfig& config, std::vector<std::string>& symbols, std::string& error) {
+    if (!config.universeFile.empty()) return loadSymbolFile(config.universeFile, symbols, error);
+    if (config.universeSize > MAX_UNIVERSE_SIZE) {
+        error = "at most " + std::to_string(MAX_UNIVERSE_SIZE) + " symbols";
+        return false;
+    }
+    symbols = config.universeSize > 0 ? syntheticSymbols(config.universeSize) : ALL_STOCKS;
+    return true;
+}
+
+// Orders flow from the trading shards to the single execution sequencer
+struct OrderRequest {
+    SymbolId symbol;
+    bool isBuy;
+    double price;
+    int quantity;
+    StrategyId strategy;     // index into StrategyRunner::getNames()
+    int64_t timestamp;       // MarketData::timestamp of the triggering tick
+    uint64_t publishCycles;  // feed stamp of the tick that triggered the order
+    double stopLoss;         // entries: exit levels rested on fill
+    double takeProfit;
+    double triggerPrice;     // exits: level that fired, 0 for discretionary orders
+    TriggerKind triggerKind;
+    uint64_t triggerCycles;  // exits: when the level was seen crossed
+    bool passive;            // rests at price instead of crossing; only a matching gateway honors it
+};
+
+enum RiskVerdict {
+    RISK_APPROVED,
+    RISK_HALTED,     // drawdown kill switch has tripped
+    RISK_NOTIONAL,   // order exceeds the symbol's notional limit
+    RISK_POSITIONS,  // open plus pending positions at the cap
+    RISK_CASH,       // not enough unreserved cash
+    RISK_RATE,       // entry rate limit reached for this second
+    RISK_VERDICT_COUNT
+};
+
+const char* riskVerdictName(int verdict) {
+    switch (verdict) {
+    case RISK_APPROVED: return "approved";
+    case RISK_HALTED: return "halted";
+    case RISK_NOTIONAL: return "notional";
+    case RISK_POSITIONS: return "positions";
+    case RISK_CASH: return "cash";
+    case RISK_RATE: return "rate";
+    }
+    return "unknown";
+}
+
+// Pre-trade check between the strategies and the execution sequencer.
+// Every check is a handful of atomic operations on precomputed limits, and
+// an approved entry reserves its cash and position slot until release(), so
+// shards approving in parallel can never over-commit the account. Exits
+// reduce risk and are always approved.
+class RiskGate {
+private:
+    std::vector<int64_t> symbolNotional;  // money units; 0 is unlimited
+    int maxPositions;
+    uint32_t maxOrdersPerSecond;
+    double drawdownFloor;                 // fraction of peak value; 0 disables
+
+    alignas(CACHE_LINE) std::atomic<int64_t> reservedCash;  // money units
+    std::atomic<int> pendingEntries;
+    // Market-time second in the high 32 bits, entries approved in it below
+    alignas(CACHE_LINE) std::atomic<uint64_t> rateWindow;
+    alignas(CACHE_LINE) std::atomic<int64_t> peakValue;  // money units
+    std::atomic<bool> halted;
+    alignas(CACHE_LINE) std::atomic<uint64_t> verdicts[RISK_VERDICT_COUNT];
+
+    static int64_t entryCost(const OrderRequest& order, int quantity) {
+        return toMoneyUnits(order.price * quantity * (1.0 + COMMISSION_RATE));
+    }
+
+    bool checkDrawdown(const TradingEngine& engine) {
+        if (drawdownFloor <= 0) return true;
+        int64_t value = toMoneyUnits(engine.getPortfolioValue());
+        int64_t peak = peakValue.load(std::memory_order_relaxed);
+        while (value > peak && !peakValue.compare_exchange_weak(peak, value, std::memory_order_relaxed)) {}
+        if (value > peak) return true;
+        if (value < static_cast<int64_t>(peak * drawdownFloor)) {
+            halted.store(true, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    bool takeRateToken(int64_t timestamp) {
+        if (maxOrdersPerSecond == 0) return true;
+        uint64_t second = static_cast<uint64_t>(timestamp / 1000000000);
+        uint64_t window = rateWindow.load(std::memory_order_relaxed);
+        while (true) {
+            uint64_t next;
+            if ((window >> 32) < second) {
+                next = (second << 32) | 1;
+            }
+            else if ((window & 0xFFFFFFFFu) >= maxOrdersPerSecond) {
+                return false;
+            }
+            else {
+                next = window + 1;
+            }
+            if (rateWindow.compare_exchange_weak(window, next, std::memory_order_relaxed)) return true;
+        }
+    }
+
+    bool reserveCash(int64_t cost, const TradingEngine& engine) {
+        int64_t cash = toMoneyUnits(engine.getCash());
+        int64_t reserved = reservedCash.load(std::memory_order_relaxed);
+        do {
+            if (reserved + cost > cash) return false;
+        } while (!reservedCash.compare_exchange_weak(reserved, reserved + cost, std::memory_order_relaxed));
+        return true;
+    }
+
+    RiskVerdict judge(const OrderRequest& order, const TradingEngine& engine) {
+        if (!order.isBuy) return RISK_APPROVED;
+        if (halted.load(std::memory_order_relaxed) || !checkDrawdown(engine)) return RISK_HALTED;
+
+        int64_t notional = toMoneyUnits(order.price * order.quantity);
+        int64_t limit = symbolNotional[order.symbol];
+        if (limit > 0 && notional > limit) return RISK_NOTIONAL;
+
+        if (maxPositions > 0) {
+            int pending = pendingEntries.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (engine.getOpenPositions() + pending > maxPositions) {
+                pendingEntries.fetch_sub(1, std::memory_order_relaxed);
+                return RISK_POSITIONS;
+            }
+        }
+
+        int64_t cost = entryCost(order, order.quantity);
+        if (!reserveCash(cost, engine)) {
+            if (maxPositions > 0) pendingEntries.fetch_sub(1, std::memory_order_relaxed);
+            return RISK_CASH;
+        }
+
+        if (!takeRateToken(order.timestamp)) {
+            reservedCash.fetch_sub(cost, std::memory_order_relaxed);
+            if (maxPositions > 0) pendingEntries.fetch_sub(1, std::memory_order_relaxed);
+            return RISK_RATE;
+        }
+        return RISK_APPROVED;
+    }
+
+public:
+    RiskGate(size_t symbols, const RiskLimits& limits, double capital)
+        : symbolNotional(symbols, toMoneyUnits(std::max(0.0, limits.maxOrderNotional))),
+        maxPositions(limits.maxOpenPositions),
+        maxOrdersPerSecond(static_cast<uint32_t>(std::max(0, limits.maxOrdersPerSecond))),
+        drawdownFloor(limits.maxDrawdown > 0 ? 1.0 - std::min(1.0, limits.maxDrawdown) : 0.0),
+        reservedCash(0), pendingEntries(0), rateWindow(0),
+        peakValue(toMoneyUnits(capital)), halted(false) {
+        for (int i = 0; i < RISK_VERDICT_COUNT; i++) verdicts[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Any thread. An approved entry holds its reservation until release().
+    RiskVerdict approve(const OrderRequest& order, const TradingEngine& engine) {
+        HFT_PROFILE_SCOPE(PROFILE_RISK);
+        RiskVerdict verdict = judge(order, engine);
+        verdicts[verdict].fetch_add(1, std::memory_order_relaxed);
+        return verdict;
+    }
+
+    // Returns an approved order's reservation once it has executed or been dropped
+    void release(const OrderRequest& order) { release(order, order.quantity, true); }
+
+    // Returns quantity shares of the reservation, and the pending position
+    // slot if `slot` (an entry keeps it until its first fill opens the position)
+    void release(const OrderRequest& order, int quantity, bool slot) {
+        if (!order.isBuy) return;
+        if (quantity > 0) reservedCash.fetch_sub(entryCost(order, quantity), std::memory_order_relaxed);
+        if (slot && maxPositions > 0) pendingEntries.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Cash not yet promised to an approved order
+    double availableCash(const TradingEngine& engine) const {
+        return engine.getCash() - fromMoneyUnits(reservedCash.load(std::memory_order_relaxed));
+    }
+
+    bool isHalted() const { return halted.load(std::memory_order_relaxed); }
+    uint64_t getVerdicts(RiskVerdict verdict) const { return verdicts[verdict].load(std::memory_order_relaxed); }
+
+    void printReport() const {
+        std::cout << Color::CYAN << "[RISK] ";
+        for (int i = 0; i < RISK_VERDICT_COUNT; i++) {
+            std::cout << (i == 0 ? "" : " | ") << riskVerdictName(i) << ": " << getVerdicts(static_cast<RiskVerdict>(i));
+        }
+        if (isHalted()) std::cout << " | KILL SWITCH TRIPPED";
+        std::cout << "\n" << Color::RESET;
+    }
+};
+
+const size_t MAX_ACCOUNTS = 64;
+
+// One independently funded sub-account: its own cash, positions and resting
+// exits in its own engine, and its own risk gate, so limits, reservations
+// and the drawdown kill switch all apply per account
+struct Account {
+    std::string name;
+    double capital;
+    TradingEngine engine;
+    RiskGate gate;
+
+    Account(const SymbolTable& symbols, const RiskLimits& limits, const std::string& label, double funds)
+        : name(label), capital(funds), engine(symbols, funds), gate(symbols.size(), limits, funds) {
+    }
+};
+
+// What one account, or the whole firm, holds at one moment
+struct AccountTotals {
+    double capital;
+    double cash;
+    double value;  // cash plus open positions at their last marks
+    double realizedPnL;
+    double unrealizedPnL;
+    int trades;
+    int openPositions;
+
+    AccountTotals() : capital(0), cash(0), value(0), realizedPnL(0), unrealizedPnL(0), trades(0), openPositions(0) {}
+
+    double exposure() const { return value - cash; }  // long market value
+    double pnl() const { return value - capital; }
+
+    void add(const AccountTotals& other) {
+        capital += other.capital;
+        cash += other.cash;
+        value += other.value;
+        realizedPnL += other.realizedPnL;
+        unrealizedPnL += other.unrealizedPnL;
+        trades += other.trades;
+        openPositions += other.openPositions;
+    }
+};
+
+struct FirmSnapshot {
+    std::vector<AccountTotals> accounts;
+    AccountTotals firm;
+};
+
+// The firm's capital split into sub-accounts by symbol group. A symbol
+// belongs to exactly one account (symbol % count, so with as many accounts
+// as shards every shard trades for one account), and that account holds its
+// position and books every order for it. Fills for different accounts share
+// no lock and no cash balance. Firm-wide figures are summed from each
+// account's lock-free readers, so the display, the exporter and the drawdown
+// sampler never take an account's execMutex.
+class AccountSet {
+private:
+    std::vector<std::unique_ptr<Account>> accounts;
+    std::vector<uint32_t> owner;  // SymbolId -> account
+
+public:
+    // Capital is split pro rata by weights; empty keeps a single account
+    AccountSet(const SymbolTable& symbols, const RiskLimits& limits, double capital,
+        const std::vector<double>& weights)
+        : owner(symbols.size(), 0) {
+        double total = 0;
+        for (size_t i = 0; i < weights.size(); i++) total += weights[i];
+        size_t count = std::max<size_t>(1, weights.size());
+        for (size_t i = 0; i < count; i++) {
+            double funds = count == 1 ? capital : capital * weights[i] / total;
+            accounts.push_back(std::make_unique<Account>(symbols, limits, "acct" + std::to_string(i + 1), funds));
+        }
+        for (SymbolId id = 0; id < owner.size(); id++) owner[id] = static_cast<uint32_t>(id % count);
+    }
+
+    size_t size() const { return accounts.size(); }
+    Account& operator[](size_t i) { return *accounts[i]; }
+    const Account& operator[](size_t i) const { return *accounts[i]; }
+    Account& forSymbol(SymbolId symbol) { return *accounts[owner[symbol]]; }
+
+    void setLogger(AsyncLogger* log) {
+        for (size_t i = 0; i < accounts.size(); i++) accounts[i]->engine.setLogger(log);
+    }
+
+    void setDepth(const BookStore* books) {
+        for (size_t i = 0; i < accounts.size(); i++) accounts[i]->engine.setDepth(books);
+    }
+
+    // Any thread, lock-free
+    double getPortfolioValue() const {
+        double value = 0;
+        for (size_t i = 0; i < accounts.size(); i++) value += accounts[i]->engine.getPortfolioValue();
+        return value;
+    }
+
+    // Any thread, lock-free. Each account is read once, so the totals can
+    // fall between two fills of different accounts but never inside one
+    // account's atomics. Reuses out's storage after the first call.
+    void snapshot(FirmSnapshot& out) const {
+        out.accounts.resize(accounts.size());
+        out.firm = AccountTotals();
+        for (size_t i = 0; i < accounts.size(); i++) {
+            const TradingEngine& engine = accounts[i]->engine;
+            AccountTotals& t = out.accounts[i];
+            t.capital = accounts[i]->capital;
+            t.cash = engine.getCash();
+            t.value = engine.getPortfolioValue();
+            t.realizedPnL = engine.getRealizedPnL();
+            t.unrealizedPnL = engine.getUnrealizedPnL();
+            t.trades = engine.getTradeCount();
+            t.openPositions = engine.getOpenPositions();
+            out.firm.add(t);
+        }
+    }
+
+    uint64_t getVerdicts(RiskVerdict verdict) const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < accounts.size(); i++) total += accounts[i]->gate.getVerdicts(verdict);
+        return total;
+    }
+
+    int getWinningTrades() {
+        int total = 0;
+        for (size_t i = 0; i < accounts.size(); i++) total += accounts[i]->engine.getWinningTrades();
+        return total;
+    }
+
+    int getLosingTrades() {
+        int total = 0;
+        for (size_t i = 0; i < accounts.size(); i++) total += accounts[i]->engine.getLosingTrades();
+        return total;
+    }
+
+    size_t getJournalChunks() {
+        size_t total = 0;
+        for (size_t i = 0; i < accounts.size(); i++) total += accounts[i]->engine.getJournalChunks();
+        return total;
+    }
+
+    // A single account prints the engine's own summary; several print one
+    // line each and the firm total
+    void printSummary() {
+        if (accounts.size() == 1) {
+            accounts[0]->engine.printSummary();
+            return;
+        }
+        FirmSnapshot snap;
+        snapshot(snap);
+
+        std::cout << "\n" << Color::BOLD << Color::CYAN;
+        std::cout << "============================================================\n";
+        std::cout << "                     FIRM SUMMARY                           \n";
+        std::cout << "============================================================\n";
+        std::cout << Color::RESET;
+        std::cout << Color::BOLD << "  Account       Capital         Value           P&L      Exposure  Trades  Open\n"
+            << Color::RESET;
+        for (size_t i = 0; i <= accounts.size(); i++) {
+            bool firm = i == accounts.size();
+            const AccountTotals& t = firm ? snap.firm : snap.accounts[i];
+            if (firm) std::cout << Color::BOLD;
+            std::cout << "  " << std::left << std::setw(8) << (firm ? std::string("firm") : accounts[i]->name)
+                << std::right << std::fixed << std::setprecision(2)
+                << std::setw(14) << t.capital << std::setw(14) << t.value
+                << (t.pnl() >= 0 ? Color::GREEN : Color::RED) << std::setw(14) << t.pnl() << Color::RESET
+                << (firm ? Color::BOLD : "")
+                << std::setw(14) << t.exposure() << std::setw(8) << t.trades << std::setw(6) << t.openPositions
+                << "\n" << Color::RESET;
+        }
+        double returnPct = snap.firm.capital > 0 ? snap.firm.pnl() / snap.firm.capital * 100 : 0.0;
+        int wins = getWinningTrades();
+        int losses = getLosingTrades();
+        std::cout << "\n" << Color::BOLD << "Firm return:          " << Color::RESET
+            << std::setprecision(2) << returnPct << "% | Realized $" << snap.firm.realizedPnL
+            << " | Unrealized $" << snap.firm.unrealizedPnL;
+        if (wins + losses > 0) {
+            std::cout << " | Win rate " << std::setprecision(1)
+                << static_cast<double>(wins) / (wins + losses) * 100 << "%";
+        }
+        std::cout << "\n\n";
+    }
+
+    // Risk, exit and depth reports, under a heading per account when there are several
+    void printReports() {
+        for (size_t i = 0; i < accounts.size(); i++) {
+            Account& account = *accounts[i];
+            if (accounts.size() > 1) {
+                std::cout << Color::BOLD << "[ACCOUNT] " << account.name << " | symbols " << i << " mod "
+                    << accounts.size() << " | $" << std::fixed << std::setprecision(2) << account.capital
+                    << " capital\n" << Color::RESET;
+            }
+            account.gate.printReport();
+            account.engine.printExitReport();
+            account.engine.printDepthReport();
+        }
+    }
+};
+
+// Comma-separated positive capital weights, at most MAX_ACCOUNTS
+bool parseWeightList(const std::string& text, std::vector<double>& weights) {
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        char* end = nullptr;
+        double value = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0' || !(value > 0) || weights.size() == MAX_ACCOUNTS) return false;
+        weights.push_back(value);
+    }
+    return !weights.empty();
+}
+
+// The strategy set plus the entry/exit rules around it. Shared by the live
+// shards and the backtester so both make exactly the same decisions.
+// Stateless after construction; callers supply per-thread scratch space.
+class StrategyRunner {
+private:
+    // Strategies 0..builtinCount-1 run through BuiltinStrategies with no
+    // virtual calls; the rest (plugins, or the built-ins themselves on the
+    // virtual path) go through TradingStrategy
+    size_t builtinCount;
+    std::vector<std::unique_ptr<TradingStrategy>> strategies;
+    std::vector<std::string> names;
+    StrategyId riskExitId;
+    TradeTuning trade;
+
+public:
+    // Custom thresholds in tuning run the built-ins as TunedRuleStrategy
+    explicit StrategyRunner(bool compileTime = true, const StrategyTuning& tuning = StrategyTuning(),
+        std::vector<std::unique_ptr<TradingStrategy>> plugins = {})
+        : builtinCount(compileTime && !tuning.customThresholds ? BuiltinStrategies::SIZE : 0),
+        trade(tuning.trade) {
+        if (builtinCount > 0) {
+            BuiltinStrategies::appendNames(names);
+        }
+        else if (tuning.customThresholds) {
+            strategies.push_back(std::make_unique<TunedRuleStrategy<MeanReversionRule, MeanRevTuning>>(tuning.meanRev));
+            strategies.push_back(std::make_unique<TunedRuleStrategy<TrendFollowingRule, TrendFollowTuning>>(tuning.trend));
+            strategies.push_back(std::make_unique<TunedRuleStrategy<BreakoutRule, BreakoutTuning>>(tuning.breakout));
+        }
+        else {
+            strategies.push_back(std::make_unique<ImprovedMeanReversionStrategy>());
+            strategies.push_back(std::make_unique<TrendFollowingStrategy>());
+            strategies.push_back(std::make_unique<BreakoutStrategy>());
+        }
+        for (size_t i = 0; i < plugins.size(); i++) {
+            strategies.push_back(std::move(plugins[i]));
+        }
+        for (size_t i = 0; i < strategies.size(); i++) {
+            names.push_back(strategies[i]->getName());
+        }
+        riskExitId = static_cast<StrategyId>(names.size());
+        names.push_back("StopLoss/TakeProfit");
+    }
+
+    // One batch kernel pass per strategy; buys[j] and sells[j] receive strategy j's bits
+    void analyzeAll(const UniverseFrame& frame, KernelIsa isa,
+        std::vector<SignalMask>& buys, std::vector<SignalMask>& sells) const {
+        HFT_PROFILE_SCOPE(PROFILE_BATCH_SIGNALS);
+        for (size_t j = 0; j < size(); j++) {
+            buys[j].clear();
+            sells[j].clear();
+        }
+        if (builtinCount > 0) BuiltinStrategies::analyzeAll(frame, isa, buys.data(), sells.data());
+
+        for (size_t k = 0; k < strategies.size(); k++) {
+            size_t j = builtinCount + k;
+            if (!strategies[k]->analyzeAll(frame, isa, buys[j], sells[j])) {
+                // No kernel: every symbol goes through analyze() in decide
+                for (size_t i = 0; i < frame.count; i++) buys[j].set(i);
+            }
+        }
+    }
+
+    // Evaluates one tick; returns true and fills in order if one should be
+    // sent. The order still has to pass the RiskGate. With batchBuys from
+    // analyzeAll, analyze() only runs for strategies whose buy bit is set.
+    bool decide(MarketDataProvider& provider, TradingEngine& engine, const RiskGate& gate, SymbolId symbol,
+        uint64_t publishCycles, std::vector<Signal>& signals, ThreadLatency& stamps,
+        OrderRequest& order, const std::vector<SignalMask>* batchBuys = nullptr) const {
+        MarketData current = provider.getData(symbol);
+        PriceWindow history = provider.getHistory(symbol);
+        Indicators ind = provider.getIndicators(symbol);
+
+        if (!current.valid()) return false;
+        engine.mark(symbol, current.mid());
+        if (history.size() < MIN_DECISION_HISTORY) return false;
+
+        PositionView pos = engine.getPosition(symbol);
+
+        order.symbol = symbol;
+        order.timestamp = current.timestamp;
+        order.publishCycles = publishCycles;
+        order.stopLoss = 0;
+        order.takeProfit = 0;
+        order.triggerPrice = 0;
+        order.triggerKind = TRIGGER_STOP;
+        order.triggerCycles = 0;
+        order.passive = false;
+
+        // Open positions exit on the tick that crosses a resting level
+        if (pos.quantity > 0) {
+            TriggerHit hit;
+            if (engine.checkTriggers(symbol, current.bid, hit)) {
+                order.isBuy = false;
+                order.price = current.bid;
+                order.quantity = pos.quantity;
+                order.strategy = riskExitId;
+                order.triggerPrice = hit.price;
+                order.triggerKind = hit.kind;
+                order.triggerCycles = cycleCounter();
+                return true;
+            }
+        }
+
+        // Only enter new positions if we're not overexposed
+        if (pos.quantity == 0) {
+            uint64_t strategyStart = cycleCounter();
+            stamps.record(STAGE_FEED_TO_STRATEGY, publishCycles, strategyStart);
+
+            // Evaluate every strategy first so the stage stamp excludes execution
+            {
+                HFT_PROFILE_SCOPE(PROFILE_STRATEGIES);
+                if (builtinCount > 0) {
+                    bool anyBuy = batchBuys == nullptr;
+                    for (size_t j = 0; j < builtinCount && !anyBuy; j++) anyBuy = (*batchBuys)[j].test(symbol);
+
+                    if (anyBuy) {
+                        BuiltinStrategies::evaluate(TickContext(current, history, ind), signals.data());
+                    }
+                    else {
+                        for (size_t j = 0; j < builtinCount; j++) signals[j] = noSignal();
+                    }
+                }
+                for (size_t k = 0; k < strategies.size(); k++) {
+                    size_t j = builtinCount + k;
+                    if (batchBuys == nullptr || (*batchBuys)[j].test(symbol)) {
+                        HFT_PROFILE_STRATEGY(j);
+                        signals[j] = strategies[k]->analyze(symbol, history, current, ind);
+                    }
+                    else {
+                        signals[j] = noSignal();
+                    }
+                }
+            }
+            stamps.record(STAGE_STRATEGY, strategyStart, cycleCounter());
+            assert(provider.historyIntact(symbol, history) && "feed lapped a history view");
+
+            for (size_t j = 0; j < size(); j++) {
+                const Signal& signal = signals[j];
+
+                if (signal.action == Signal::BUY && signal.confidence > MIN_ENTRY_CONFIDENCE) {
+                    double portfolioValue = gate.availableCash(engine);
+                    // Balanced position sizing (2% per trade for more activity)
+                    int qty = static_cast<int>((portfolioValue * trade.positionFraction) / current.ask);
+
+                    if (qty > 0) {
+                        order.isBuy = true;
+                        order.price = trade.passiveEntries ? current.bid : current.ask;
+                        order.passive = trade.passiveEntries;
+                        order.quantity = qty;
+                        order.strategy = static_cast<StrategyId>(j);
+                        bracket(signal, order.price, order);
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // The strategy's own stop and target, clamped to the outer bounds
+    void bracket(const Signal& signal, double ask, OrderRequest& order) const {
+        double entry = ask * (1.0 + COMMISSION_RATE);
+        double floor = entry * (1.0 - trade.stopLossPct);
+        double ceiling = entry * (1.0 + trade.takeProfitPct);
+        order.stopLoss = signal.stopLoss < entry ? std::max(signal.stopLoss, floor) : floor;
+        order.takeProfit = signal.takeProfit > entry ? std::min(signal.takeProfit, ceiling) : ceiling;
+    }
+
+    // Fills a risk-approved order; returns false if the engine refused it
+    bool execute(TradingEngine& engine, const OrderRequest& order) const {
+        if (order.isBuy) {
+            return engine.executeBuy(order.symbol, order.price, order.quantity,
+                order.strategy, order.timestamp, order.stopLoss, order.takeProfit);
+        }
+        double fillPrice = order.price;
+        bool filled = engine.executeSell(order.symbol, order.price, order.quantity,
+            order.strategy, order.timestamp, &fillPrice);
+        if (filled && order.triggerPrice > 0) {
+            engine.recordTriggeredExit(order.triggerKind, order.triggerPrice, fillPrice);
+        }
+        return filled;
+    }
+
+    size_t size() const { return builtinCount + strategies.size(); }
+    bool isCompileTime() const { return builtinCount > 0; }
+    const std::vector<std::string>& getNames() const { return names; }
+};
+
+using OrderId = uint64_t;  // 0 is never assigned
+
+enum ExecType { EXEC_ACK, EXEC_FILL, EXEC_REJECT, EXEC_CANCEL };
+
+// What a gateway reports back about an order it was sent
+struct ExecutionReport {
+    OrderId id;
+    ExecType type;
+    int quantity;    // fills: shares in this fill; cancels: shares left unfilled
+    double price;    // fills: execution price
+    int64_t nanos;   // gateway clock when the event happened
+};
+
+// Where the OMS sends orders: a simulated venue or a session to a real one.
+// Both calls are non-blocking and come from the sequencer thread only; the
+// clock is the caller's (market time in a backtest, monotonic time live).
+class ExchangeGateway {
+public:
+    // False if the gateway cannot take the order now
+    virtual bool send(OrderId id, const OrderRequest& order, int64_t nowNanos) = 0;
+    // Next report due at nowNanos, if any
+    virtual bool poll(int64_t nowNanos, ExecutionReport& report) = 0;
+    virtual std::string describe() const = 0;
+    virtual ~ExchangeGateway() {}
+};
+
+// Acks each order latencyNanos after it is sent, then fills it in `slices`
+// equal parts, one further latency apart. With no latency the order fills
+// at its own price, exactly like the old synchronous path; with latency it
+// fills at the touch when each slice comes due, and a touch that has moved
+// more than collarBps against the order price rejects what is left.
+class SimulatedGateway : public ExchangeGateway {
+private:
+    struct Pending {
+        OrderId id;
+        OrderRequest order;
+        int64_t due;
+        int leaves;
+        bool acked;
+    };
+
+    MarketDataProvider& provider;
+    GatewayConfig config;
+    std::vector<Pending> ring;  // FIFO in due order; latency is the same for every order
+    size_t head;
+    size_t count;
+
+    int sliceSize(const Pending& p) const {
+        int slice = std::max(1, (p.order.quantity + config.slices - 1) / config.slices);
+        return std::min(slice, p.leaves);
+    }
+
+    void popFront() {
+        head = (head + 1) % ring.size();
+        count--;
+    }
+
+public:
+    SimulatedGateway(MarketDataProvider& data, const GatewayConfig& cfg, size_t capacity)
+        : provider(data), config(cfg), ring(std::max<size_t>(1, capacity)), head(0), count(0) {
+        config.slices = std::max(1, config.slices);
+        config.latencyNanos = std::max<int64_t>(0, config.latencyNanos);
+    }
+
+    bool send(OrderId id, const OrderRequest& order, int64_t nowNanos) override {
+        if (count == ring.size()) return false;
+        Pending& p = ring[(head + count) % ring.size()];
+        p.id = id;
+        p.order = order;
+        p.due = nowNanos + config.latencyNanos;
+        p.leaves = order.quantity;
+        p.acked = false;
+        count++;
+        return true;
+    }
+
+    bool poll(int64_t nowNanos, ExecutionReport& report) override {
+        if (count == 0) return false;
+        Pending& p = ring[head];
+        if (p.due > nowNanos) return false;
+
+        report.id = p.id;
+        report.nanos = p.due;
+        if (!p.acked) {
+            p.acked = true;
+            report.type = EXEC_ACK;
+            return true;
+        }
+
+        double price = p.order.price;
+        if (config.latencyNanos > 0) {
+            MarketData quote = provider.getData(p.order.symbol);
+            price = p.order.isBuy ? quote.ask : quote.bid;
+            double collar = config.collarBps / 10000.0;
+            bool moved = p.order.isBuy ? price > p.order.price * (1.0 + collar) : price < p.order.price * (1.0 - collar);
+            if (!quote.valid() || (config.collarBps > 0 && moved)) {
+                report.type = EXEC_REJECT;
+                popFront();
+                return true;
+            }
+        }
+        report.type = EXEC_FILL;
+        report.quantity = sliceSize(p);
+        report.price = price;
+        p.leaves -= report.quantity;
+        p.due += config.latencyNanos;
+        if (p.leaves == 0) popFront();
+        return true;
+    }
+
+    std::string describe() const override {
+        std::ostringstream out;
+        out << "simulated, " << config.latencyNanos / 1000 << " us latency, " << config.slices
+            << (config.slices == 1 ? " fill" : " fills") << " per order";
+        if (config.collarBps > 0) out << ", " << config.collarBps << " bps collar";
+        return out.str();
+    }
+};
+
+// A venue simulator with its own matching rules. Messages take half the
+// configured round trip each way plus an exponential jitter, so orders
+// reach the venue after the market has moved and reports come back later
+// still. On arrival a marketable order sweeps the visible depth (the
+// provider's books, or the synthetic ladder the books would lay) up to its
+// limit, one fill per level, and shares it takes are gone until the next
+// quote. What a market order cannot fill is cancelled; a passive order
+// rests at its limit behind the quantity already shown there, advances
+// as the touch trades, and fills when it reaches the front or the far side
+// trades through it. Resting orders are cancelled after restTimeoutNanos.
+// The rng is seeded from the run seed, so a backtest stays reproducible.
+// Everything is preallocated; poll() does no allocation.
+class MatchingGateway : public ExchangeGateway {
+private:
+    struct VenueOrder {
+        OrderId id;
+        OrderRequest order;
+        int leaves;
+        int64_t queueAhead;  // shares in front of us at our price
+        int64_t lastSeen;    // timestamp of the last quote applied to the queue
+        int64_t expires;
+    };
+
+    struct Scheduled {
+        int64_t due;
+        uint64_t seq;          // keeps events with the same due time in order
+        uint32_t slot;         // arrivals: the venue order
+        ExecutionReport report;
+
+        bool operator>(const Scheduled& other) const {
+            return due != other.due ? due > other.due : seq > other.seq;
+        }
+    };
+
+    MarketDataProvider& provider;
+    GatewayConfig config;
+    Xoshiro256 rng;
+    std::vector<VenueOrder> orders;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> resting;
+    std::vector<Scheduled> arrivals;  // min-heaps on due
+    std::vector<Scheduled> reports;
+    uint64_t seq;
+    int64_t lastArrival;  // one session each way: messages never overtake each other
+    int64_t lastReport;
+    int64_t advancedTo;
+    bool dirty;
+    // Liquidity already taken from each symbol's current quote, by side
+    std::vector<int64_t> takenStamp;
+    std::vector<int64_t> taken[2];
+
+    int64_t oneWay() {
+        int64_t nanos = config.latencyNanos / 2;
+        if (config.jitterNanos > 0) nanos += static_cast<int64_t>(-config.jitterNanos * std::log(rng.uniform()));
+        return nanos;
+    }
+
+    void pushEvent(std::vector<Scheduled>& heap, const Scheduled& event) {
+        heap.push_back(event);
+        std::push_heap(heap.begin(), heap.end(), std::greater<Scheduled>());
+    }
+
+    Scheduled popEvent(std::vector<Scheduled>& heap) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Scheduled>());
+        Scheduled event = heap.back();
+        heap.pop_back();
+        return event;
+    }
+
+    void report(OrderId id, ExecType type, int quantity, double price, int64_t at) {
+        Scheduled event;
+        event.due = lastReport = std::max(lastReport, at + oneWay());
+        event.seq = seq++;
+        event.slot = 0;
+        event.report.id = id;
+        event.report.type = type;
+        event.report.quantity = quantity;
+        event.report.price = price;
+        event.report.nanos = at;
+        pushEvent(reports, event);
+    }
+
+    void release(uint32_t slot) {
+        orders[slot].id = 0;
+        freeSlots.push_back(slot);
+    }
+
+    void readDepth(const MarketData& quote, BookDepth& depth) const {
+        const BookStore* books = provider.getBooks();
+        if (books != nullptr) books->read(quote.symbol, depth);
+        else syntheticDepth(quote, DEFAULT_BOOK_LEVELS, depth);
+    }
+
+    // Takes up to o.leaves shares from the far side at prices no worse than
+    // limit; each level taken is reported as its own fill
+    void sweep(VenueOrder& o, const MarketData& quote, double limit, int64_t at) {
+        SymbolId id = o.order.symbol;
+        BookSide side = o.order.isBuy ? BOOK_ASK : BOOK_BID;
+        if (takenStamp[id] != quote.timestamp) {
+            takenStamp[id] = quote.timestamp;
+            taken[BOOK_BID][id] = 0;
+            taken[BOOK_ASK][id] = 0;
+        }
+        BookDepth depth;
+        readDepth(quote, depth);
+        int64_t skip = taken[side][id];
+        for (uint32_t k = 0; k < depth.levels[side] && o.leaves > 0; k++) {
+            double price = depth.price[side][k];
+            if (o.order.isBuy ? price > limit : price < limit) break;
+            int64_t available = depth.quantity[side][k] - skip;
+            skip = std::max<int64_t>(0, -available);
+            if (available <= 0) continue;
+            int qty = static_cast<int>(std::min<int64_t>(o.leaves, available));
+            o.leaves -= qty;
+            taken[side][id] += qty;
+            report(o.id, EXEC_FILL, qty, price, at);
+        }
+    }
+
+    // The order reaches the venue: match what crosses, rest or cancel the rest
+    void arrive(uint32_t slot, int64_t at) {
+        VenueOrder& o = orders[slot];
+        MarketData quote = provider.getData(o.order.symbol);
+        if (!quote.valid()) {
+            report(o.id, EXEC_REJECT, 0, 0.0, at);
+            release(slot);
+            return;
+        }
+        report(o.id, EXEC_ACK, 0, 0.0, at);
+
+        double collar = config.collarBps / 10000.0;
+        double limit = o.order.passive ? o.order.price
+            : config.collarBps > 0 ? o.order.price * (o.order.isBuy ? 1.0 + collar : 1.0 - collar)
+            : (o.order.isBuy ? std::numeric_limits<double>::infinity() : 0.0);
+        sweep(o, quote, limit, at);
+        if (o.leaves == 0) {
+            release(slot);
+            return;
+        }
+        if (!o.order.passive) {
+            report(o.id, EXEC_CANCEL, o.leaves, 0.0, at);
+            release(slot);
+            return;
+        }
+
+        // Join the back of the queue at our price; inside the spread we are alone
+        BookDepth depth;
+        readDepth(quote, depth);
+        BookSide own = o.order.isBuy ? BOOK_BID : BOOK_ASK;
+        int64_t ticks = toBookTicks(o.order.price);
+        o.queueAhead = 0;
+        for (uint32_t k = 0; k < depth.levels[own]; k++) {
+            if (toBookTicks(depth.price[own][k]) == ticks) o.queueAhead = depth.quantity[own][k];
+        }
+        o.lastSeen = quote.timestamp;
+        o.expires = at + config.restTimeoutNanos;
+        resting.push_back(slot);
+    }
+
+    // Advances a resting order by one new quote; true once it is done
+    bool advance(VenueOrder& o, const MarketData& quote, int64_t at) {
+        double price = o.order.price;
+        bool buy = o.order.isBuy;
+        double farTouch = buy ? quote.ask : quote.bid;
+        double nearTouch = buy ? quote.bid : quote.ask;
+        int fill = 0;
+        if (buy ? farTouch <= price : farTouch >= price) {
+            // The far side traded through us: everything ahead went too
+            fill = o.leaves;
+        }
+        else if (buy ? nearTouch <= price + BOOK_TICK_SIZE / 2 : nearTouch >= price - BOOK_TICK_SIZE / 2) {
+            int64_t touch = syntheticTouchSize(quote);
+            int64_t traded = static_cast<int64_t>(touch * config.touchTurnover * rng.uniform());
+            bool atTouch = std::abs(nearTouch - price) < BOOK_TICK_SIZE / 2;
+            if (!atTouch) o.queueAhead = 0;  // we are the best price on our side
+            o.queueAhead -= traded;
+            if (o.queueAhead < 0) {
+                fill = static_cast<int>(std::min<int64_t>(o.leaves, -o.queueAhead));
+                o.queueAhead = 0;
+            }
+        }
+        if (fill > 0) {
+            o.leaves -= fill;
+            report(o.id, EXEC_FILL, fill, price, at);
+        }
+        if (o.leaves > 0 && at >= o.expires) {
+            report(o.id, EXEC_CANCEL, o.leaves, 0.0, at);
+            o.leaves = 0;
+        }
+        return o.leaves == 0;
+    }
+
+    void advanceTo(int64_t nowNanos) {
+        while (!arrivals.empty() && arrivals.front().due <= nowNanos) {
+            Scheduled event = popEvent(arrivals);
+            arrive(event.slot, event.due);
+        }
+        for (size_t i = 0; i < resting.size();) {
+            uint32_t slot = resting[i];
+            VenueOrder& o = orders[slot];
+            MarketData quote = provider.getData(o.order.symbol);
+            bool done = false;
+            if (quote.timestamp != o.lastSeen) {
+                o.lastSeen = quote.timestamp;
+                done = advance(o, quote, nowNanos);
+            }
+            else if (nowNanos >= o.expires) {
+                report(o.id, EXEC_CANCEL, o.leaves, 0.0, nowNanos);
+                done = true;
+            }
+            if (done) {
+                release(slot);
+                resting[i] = resting.back();
+                resting.pop_back();
+            }
+            else {
+                i++;
+            }
+        }
+        advancedTo = nowNanos;
+        dirty = false;
+    }
+
+public:
+    MatchingGateway(MarketDataProvider& data, const GatewayConfig& cfg, size_t symbols, uint64_t seed)
+        : provider(data), config(cfg), rng(seed), orders(std::max<size_t>(1, symbols)),
+        seq(0), lastArrival(0), lastReport(0), advancedTo(std::numeric_limits<int64_t>::min()), dirty(false),
+        takenStamp(symbols, 0) {
+        config.latencyNanos = std::max<int64_t>(0, config.latencyNanos);
+        config.jitterNanos = std::max<int64_t>(0, config.jitterNanos);
+        for (size_t i = orders.size(); i-- > 0;) {
+            orders[i].id = 0;
+            freeSlots.push_back(static_cast<uint32_t>(i));
+        }
+        resting.reserve(orders.size());
+        arrivals.reserve(orders.size());
+        // An order yields an ack, a fill per book level and a cancel at most
+        reports.reserve(orders.size() * (BOOK_SNAPSHOT_LEVELS + 2));
+        taken[BOOK_BID].assign(symbols, 0);
+        taken[BOOK_ASK].assign(symbols, 0);
+    }
+
+    bool send(OrderId id, const OrderRequest& order, int64_t nowNanos) override {
+        if (freeSlots.empty()) return false;
+        uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        VenueOrder& o = orders[slot];
+        o.id = id;
+        o.order = order;
+        o.leaves = order.quantity;
+        Scheduled event;
+        event.due = lastArrival = std::max(lastArrival, nowNanos + oneWay());
+        event.seq = seq++;
+        event.slot = slot;
+        pushEvent(arrivals, event);
+        dirty = true;
+        return true;
+    }
+
+    bool poll(int64_t nowNanos, ExecutionReport& out) override {
+        if (dirty || nowNanos != advancedTo) advanceTo(nowNanos);
+        if (reports.empty() || reports.front().due > nowNanos) return false;
+        out = popEvent(reports).report;
+        return true;
+    }
+
+    std::string describe() const override {
+        const BookStore* books = provider.getBooks();
+        std::ostringstream out;
+        out << "matching, " << config.latencyNanos / 1000 << " us round trip";
+        if (config.jitterNanos > 0) out << " + " << config.jitterNanos / 1000 << " us jitter each way";
+        out << ", depth from " << (books != nullptr ? "the books" : "synthetic levels");
+        if (config.collarBps > 0) out << ", " << config.collarBps << " bps collar";
+        return out.str();
+    }
+};
+
+// The venue config.model selects; a matching venue reads the provider's
+// books when they are enabled, and synthetic levels otherwise
+inline std::unique_ptr<ExchangeGateway> makeGateway(MarketDataProvider& provider, const GatewayConfig& config,
+    size_t symbols, uint64_t seed) {
+    if (config.model == GatewayModel::Matching) {
+        return std::make_unique<MatchingGateway>(provider, config, symbols, seed);
+    }
+    return std::make_unique<SimulatedGateway>(provider, config, symbols);
+}
+
+// Written by the sequencer; the metrics exporter reads them while it runs
+struct OrderCounters {
+    StatCounter submitted;
+    StatCounter acked;
+    StatCounter fills;
+    StatCounter partialFills;
+    StatCounter rejected;
+    StatCounter cancelled;
+    StatCounter ackNanos;  // summed send-to-ack time
+};
+
+// Order management between the risk gate and a gateway. Each approved order
+// gets an id and a slot in a fixed table (the id's low bits), goes to the
+// gateway without blocking, and is booked into the engine fill by fill as
+// reports come back. Its risk reservation is returned share by share as it
+// fills and in full when it finishes, so the position cap and cash checks
+// count every order still in flight. At most one order per symbol is live.
+// Each order is booked into, and reserved against, the account that owns
+// its symbol. All of it runs on the sequencer thread except the in-flight flags,
+// which the trading shards check and claim.
+class OrderManager {
+private:
+    struct LiveOrder {
+        OrderId id;     // 0 while the slot is free
+        OrderRequest order;
+        int filled;
+        int64_t sentNanos;
+    };
+
+    ExchangeGateway& gateway;
+    AccountSet& accounts;
+    const StrategyRunner& runner;
+    AsyncLogger* logger;
+    std::vector<LiveOrder> live;
+    std::vector<uint32_t> freeSlots;
+    uint64_t slotMask;
+    int slotBits;
+    uint64_t sequence;
+    std::vector<std::atomic<bool>> inFlight;
+
+    OrderCounters counters;
+
+    void logReject(const OrderRequest& order) {
+        if (logger == nullptr || !logger->enabled(LOG_DEBUG)) return;
+        LogRecord rec;
+        rec.event = LOG_REJECT;
+        rec.level = LOG_DEBUG;
+        rec.strategy = order.strategy;
+        rec.symbol = order.symbol;
+        rec.quantity = order.quantity;
+        rec.price = order.price;
+        rec.amount = 0;
+        rec.wallNanos = order.timestamp;
+        rec.cycles = cycleCounter();
+        logger->log(rec);
+    }
+
+    // Returns the unfilled part of the reservation and frees the symbol
+    void finish(uint32_t slot) {
+        LiveOrder& o = live[slot];
+        accounts.forSymbol(o.order.symbol).gate.release(o.order, o.order.quantity - o.filled, o.filled == 0);
+        inFlight[o.order.symbol].store(false, std::memory_order_release);
+        o.id = 0;
+        freeSlots.push_back(slot);
+    }
+
+    void reject(uint32_t slot) {
+        counters.rejected.add();
+        logReject(live[slot].order);
+        finish(slot);
+    }
+
+    void fill(uint32_t slot, const ExecutionReport& report, ThreadLatency& stamps) {
+        LiveOrder& o = live[slot];
+        OrderRequest slice = o.order;
+        slice.quantity = std::min(report.quantity, o.order.quantity - o.filled);
+        slice.price = report.price;
+        // An exit is measured against its trigger level once, on its first fill
+        if (o.filled > 0) slice.triggerPrice = 0;
+        Account& account = accounts.forSymbol(o.order.symbol);
+        if (slice.quantity <= 0 || !runner.execute(account.engine, slice)) {
+            reject(slot);
+            return;
+        }
+        counters.fills.add();
+        bool first = o.filled == 0;
+        o.filled += slice.quantity;
+        account.gate.release(o.order, slice.quantity, first);
+        if (first) {
+            uint64_t filledCycles = cycleCounter();
+            stamps.record(STAGE_TICK_TO_TRADE, o.order.publishCycles, filledCycles);
+            if (o.order.triggerCycles != 0) stamps.record(STAGE_TRIGGER_TO_FILL, o.order.triggerCycles, filledCycles);
+        }
+        if (o.filled < o.order.quantity) {
+            counters.partialFills.add();
+            return;
+        }
+        finish(slot);
+    }
+
+public:
+    OrderManager(ExchangeGateway& gw, AccountSet& books, const StrategyRunner& strategies, size_t symbols)
+        : gateway(gw), accounts(books), runner(strategies), logger(nullptr), slotBits(0), sequence(0),
+        inFlight(symbols) {
+        while ((size_t(1) << slotBits) < symbols + 1) slotBits++;
+        slotMask = (uint64_t(1) << slotBits) - 1;
+        live.resize(size_t(1) << slotBits);
+        freeSlots.reserve(live.size());
+        for (size_t i = live.size(); i-- > 0;) {
+            live[i].id = 0;
+            freeSlots.push_back(static_cast<uint32_t>(i));
+        }
+        for (size_t i = 0; i < symbols; i++) inFlight[i].store(false, std::memory_order_relaxed);
+    }
+
+    // Rejects are logged at debug level; null disables it
+    void setLogger(AsyncLogger* log) { logger = log; }
+
+    // Any thread. A shard claims the symbol before queueing an order for it
+    // and gives it back with unclaim() if the order never reaches submit().
+    bool isInFlight(SymbolId symbol) const { return inFlight[symbol].load(std::memory_order_acquire); }
+    void claim(SymbolId symbol) { inFlight[symbol].store(true, std::memory_order_relaxed); }
+    void unclaim(SymbolId symbol) { inFlight[symbol].store(false, std::memory_order_release); }
+
+    // Sequencer thread. Takes over the approved order's risk reservation
+    // and the symbol's claim; returns 0 if the order could not be sent.
+    OrderId submit(const OrderRequest& order, int64_t nowNanos) {
+        inFlight[order.symbol].store(true, std::memory_order_relaxed);
+        if (freeSlots.empty()) {
+            counters.rejected.add();
+            accounts.forSymbol(order.symbol).gate.release(order);
+            unclaim(order.symbol);
+            return 0;
+        }
+        uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        OrderId id = (++sequence << slotBits) | slot;
+        LiveOrder& o = live[slot];
+        o.id = id;
+        o.order = order;
+        o.filled = 0;
+        o.sentNanos = nowNanos;
+        counters.submitted.add();
+        if (!gateway.send(id, order, nowNanos)) {
+            reject(slot);
+            return 0;
+        }
+        return id;
+    }
+
+    // Sequencer thread: books every report the gateway has due by nowNanos
+    void process(int64_t nowNanos, ThreadLatency& stamps) {
+        ExecutionReport report;
+        while (gateway.poll(nowNanos, report)) {
+            uint32_t slot = static_cast<uint32_t>(report.id & slotMask);
+            if (live[slot].id != report.id) continue;  // order already finished
+            if (report.type == EXEC_ACK) {
+                counters.acked.add();
+                counters.ackNanos.add(static_cast<uint64_t>(std::max<int64_t>(0, report.nanos - live[slot].sentNanos)));
+            }
+            else if (report.type == EXEC_FILL) {
+                fill(slot, report, stamps);
+            }
+            else if (report.type == EXEC_CANCEL) {
+                // The venue let the rest go: unfilled IOC or timed-out resting shares
+                counters.cancelled.add();
+                finish(slot);
+            }
+            else {
+                reject(slot);
+            }
+        }
+    }
+
+    // Drops every live order at shutdown; shares already filled stay booked
+    void cancelAll() {
+        for (uint32_t slot = 0; slot < live.size(); slot++) {
+            if (live[slot].id == 0) continue;
+            counters.cancelled.add();
+            finish(slot);
+        }
+    }
+
+    size_t liveOrders() const { return live.size() - freeSlots.size(); }
+    uint64_t getRejected() const { return counters.rejected.get(); }
+    const OrderCounters& getCounters() const { return counters; }
+
+    void printReport() const {
+        uint64_t acked = counters.acked.get();
+        std::cout << Color::CYAN << "[OMS] " << gateway.describe() << " | submitted: " << counters.submitted.get()
+            << " | acked: " << acked << " | fills: " << counters.fills.get()
+            << " (" << counters.partialFills.get() << " partial)"
+            << " | rejected: " << counters.rejected.get() << " | cancelled: " << counters.cancelled.get();
+        if (acked > 0) {
+            std::cout << " | avg ack " << std::fixed << std::setprecision(1)
+                << counters.ackNanos.get() / 1000.0 / acked << " us";
+        }
+        std::cout << "\n" << Color::RESET;
+    }
+};
+
+const int METRICS_ACCEPT_TIMEOUT_MS = 100;    // how often the exporter checks for shutdown
+const int METRICS_REQUEST_TIMEOUT_MS = 1000;  // the whole request, however it trickles in
+const size_t METRICS_MAX_REQUEST = 4096;
+
+// Anything that can render its current state as Prometheus text
+class MetricsSource {
+public:
+    // Called from the exporter thread; must read only lock-free state
+    virtual void writeMetrics(std::ostream& out) const = 0;
+    virtual ~MetricsSource() {}
+};
+
+// Prometheus text exposition helpers
+void writeMetricHeader(std::ostream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+}
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (size_t i = 0; i < value.size(); i++) {
+        if (value[i] == '\\' || value[i] == '"') escaped += '\\';
+        if (value[i] == '\n') escaped += "\\n";
+        else escaped += value[i];
+    }
+    return escaped;
+}
+
+// Serves GET /metrics over HTTP/1.0 on its own thread. Each scrape renders
+// the source afresh, so the trading threads only ever bump their own
+// counters and never see the exporter.
+class MetricsServer {
+private:
+    const MetricsSource& source;
+    std::string host;
+    uint16_t port;
+    SocketHandle listener;
+    std::atomic<bool> running;
+    std::thread thread;
+    std::atomic<uint64_t> scrapes;
+
+    static void sendAll(SocketHandle client, const std::string& data) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;  // a scraper hanging up must not raise SIGPIPE
+#else
+        const int flags = 0;
+#endif
+        size_t sent = 0;
+        while (sent < data.size()) {
+            int n = static_cast<int>(::send(client, data.data() + sent, static_cast<int>(data.size() - sent), flags));
+            if (n <= 0) return;
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    void respond(SocketHandle client) {
+        // One deadline for the whole request, so a slow client cannot hold
+        // the only exporter thread by sending a byte at a time
+        int64_t deadline = monotonicNanos() + static_cast<int64_t>(METRICS_REQUEST_TIMEOUT_MS) * 1000000;
+        char buffer[METRICS_MAX_REQUEST];
+        size_t length = 0;
+        while (length < sizeof(buffer)) {
+            int64_t remaining = deadline - monotonicNanos();
+            if (remaining <= 0) return;
+            setReceiveTimeout(client, static_cast<int>((remaining + 999999) / 1000000));
+            int n = static_cast<int>(::recv(client, buffer + length, static_cast<int>(sizeof(buffer) - length), 0));
+            if (n <= 0) {
+                if (monotonicNanos() >= deadline) return;
+                break;
+            }
+            length += static_cast<size_t>(n);
+            if (std::string(buffer, length).find("\r\n\r\n") != std::string::npos) break;
+        }
+        std::string request(buffer, length);
+        std::string method = request.substr(0, request.find(' '));
+        size_t pathStart = method.size() + 1;
+        std::string path = pathStart < request.size()
+            ? request.substr(pathStart, request.find_first_of(" ?\r", pathStart) - pathStart) : "";
+
+        std::string status = "200 OK";
+        std::string type = "text/plain; version=0.0.4";
+        std::ostringstream body;
+        if (method == "GET" && path == "/metrics") {
+            source.writeMetrics(body);
+            scrapes.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (method == "GET") {
+            status = "404 Not Found";
+            type = "text/plain";
+            body << "metrics are served at /metrics\n";
+        }
+        else {
+            status = "405 Method Not Allowed";
+            type = "text/plain";
+        }
+        std::string payload = body.str();
+        std::ostringstream head;
+        head << "HTTP/1.0 " << status << "\r\nContent-Type: " << type << "\r\nContent-Length: " << payload.size()
+            << "\r\nConnection: close\r\n\r\n";
+        sendAll(client, head.str() + payload);
+    }
+
+    void serve() {
+        while (running.load(std::memory_order_relaxed)) {
+            fd_set ready;
+            FD_ZERO(&ready);
+            FD_SET(listener, &ready);
+            timeval timeout;
+            timeout.tv_sec = 0;
+            timeout.tv_usec = METRICS_ACCEPT_TIMEOUT_MS * 1000;
+            if (select(static_cast<int>(listener) + 1, &ready, nullptr, nullptr, &timeout) <= 0) continue;
+            SocketHandle client = accept(listener, nullptr, nullptr);
+            if (client == NO_SOCKET) continue;
+            respond(client);
+            closeSocket(client);
+        }
+    }
+
+public:
+    explicit MetricsServer(const MetricsSource& src)
+        : source(src), port(0), listener(NO_SOCKET), running(false), scrapes(0) {
+    }
+
+    ~MetricsServer() { stop(); }
+
+    // [HOST:]PORT; the host defaults to loopback, * listens on every interface
+    bool start(const std::string& address, std::string& error) {
+        size_t colon = address.rfind(':');
+        host = colon == std::string::npos ? "127.0.0.1" : address.substr(0, colon);
+        uint64_t parsed = 0;
+        if (!parseUnsigned(address.substr(colon == std::string::npos ? 0 : colon + 1), 65535, parsed) || parsed == 0) {
+            error = "bad port";
+            return false;
+        }
+        port = static_cast<uint16_t>(parsed);
+
+        sockaddr_in addr;
+        if (!initSockets() || !resolveIpv4(host, port, addr)) {
+            error = "cannot resolve " + host;
+            return false;
+        }
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener == NO_SOCKET) {
+            error = "socket() failed";
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+        if (bind(listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 8) != 0) {
+            error = "cannot listen on " + address + " (error " + std::to_string(lastSocketError()) + ")";
+            closeSocket(listener);
+            listener = NO_SOCKET;
+            return false;
+        }
+        running = true;
+        thread = std::thread(&MetricsServer::serve, this);
+        return true;
+    }
+
+    void stop() {
+        running = false;
+        if (thread.joinable()) thread.join();
+        if (listener != NO_SOCKET) closeSocket(listener);
+        listener = NO_SOCKET;
+    }
+
+    std::thread& getThread() { return thread; }
+    uint64_t getScrapes() const { return scrapes.load(std::memory_order_relaxed); }
+
+    std::string describe() const {
+        return "http://" + (host == "*" ? std::string("0.0.0.0") : host) + ":" + std::to_string(port) + "/metrics";
+    }
+};
+
+// A fixed slice of the universe (symbol % shardCount) evaluated by one worker.
+// Nothing here is shared with other shards; orders leave through an SPSC
+// queue drained by the execution sequencer.
+struct TradingShard {
+    size_t index;
+    TickChannel ticks;
+    SpscQueue<OrderRequest> orders;
+    std::vector<Signal> signals;
+    ThreadLatency* latency;
+    StatCounter ticksProcessed;
+    StatCounter ordersDropped;
+    std::vector<StatCounter> ordersProposed;  // by StrategyId, before the risk gate
+    std::thread thread;
+
+    TradingShard(size_t shardIndex, WaitPolicy policy, size_t strategyCount, size_t strategyIds,
+        ThreadLatency* stamps)
+        : index(shardIndex), ticks(TICK_QUEUE_CAPACITY, policy), orders(ORDER_QUEUE_CAPACITY),
+        signals(strategyCount), latency(stamps), ordersProposed(strategyIds) {
+    }
+};
+
+const int HEADLESS_STATUS_SECONDS = 10;
+
+class HFTSystem : public MetricsSource {
+private:
+    const SymbolTable& symbols;
+    SystemConfig config;
+    std::unique_ptr<TickRecorder> recorder;
+    FeedHandler* feedHandler;  // owned by main; null when simulating or replaying
+    WriteAheadJournal* journal;  // owned by main; null keeps the account in memory only
+    std::unique_ptr<MarketDataProvider> dataProvider;
+    AccountSet accounts;
+    StrategyRunner runner;
+    std::unique_ptr<AsyncLogger> logger;
+    std::atomic<bool> running;
+    std::vector<std::unique_ptr<TradingShard>> shards;
+    std::thread executionThread;
+    std::thread displayThread;
+    std::thread journalThread;
+    std::vector<std::string> placementLog;
+    bool placementFailed;
+    std::vector<double> entryPrices;
+    double initialCapital;
+    bool warmStarted;  // every symbol already has enough history to trade
+    std::unique_ptr<ExchangeGateway> gateway;
+    std::unique_ptr<OrderManager> oms;
+
+    // One histogram set per shard plus one for the sequencer
+    std::vector<std::unique_ptr<ThreadLatency>> latency;
+    std::unique_ptr<MetricsServer> metrics;
+
+    void place(const std::string& role, ThreadHandle handle, int cpu, bool hotPath) {
+        std::string line;
+        if (!placeThread(role, handle, cpu, hotPath, config.placement, line)) placementFailed = true;
+        placementLog.push_back(line);
+    }
+
+    // A symbol never has two orders in flight: the shard claims it here and
+    // the OMS frees it once the order has finished
+    void submit(TradingShard& shard, const OrderRequest& order) {
+        oms->claim(order.symbol);
+        if (!shard.orders.push(order)) {
+            accounts.forSymbol(order.symbol).gate.release(order);
+            oms->unclaim(order.symbol);
+            shard.ordersDropped.add();
+        }
+    }
+
+    void onTick(TradingShard& shard, const TickEvent& event) {
+        SymbolId symbol = event.symbol;
+        if (oms->isInFlight(symbol)) return;
+
+        OrderRequest order;
+        Account& account = accounts.forSymbol(symbol);
+        if (runner.decide(*dataProvider, account.engine, account.gate, symbol, event.publishCycles,
+            shard.signals, *shard.latency, order)) {
+            shard.ordersProposed[order.strategy].add();
+            uint64_t riskStart = cycleCounter();
+            RiskVerdict verdict = account.gate.approve(order, account.engine);
+            shard.latency->record(STAGE_RISK, riskStart, cycleCounter());
+            if (verdict != RISK_APPROVED) return;
+
+            submit(shard, order);
+            if (order.isBuy) entryPrices[symbol] = order.price;
+        }
+    }
+
+    void shardLoop(TradingShard* shard) {
+        // Ticks queued during warm-up are stale; start from the live feed
+        shard->ticks.discardPending();
+
+        TickEvent event;
+        while (running) {
+            if (!shard->ticks.next(event, running)) continue;
+
+            onTick(*shard, event);
+
+            shard->latency->record(STAGE_TICK_TO_DECISION, event.publishCycles, cycleCounter());
+            shard->ticksProcessed.add();
+        }
+    }
+
+    // Single risk/execution sequencer: the only thread that mutates the accounts.
+    // It hands queued orders to the OMS and books whatever the gateway reports.
+    void executionLoop() {
+        std::cout << Color::YELLOW << "\n[SYSTEM] Trading engine started - " << shards.size()
+            << " shard(s) waiting for ticks...\n" << Color::RESET << "\n";
+
+        ThreadLatency& stamps = *latency.back();
+        OrderRequest order;
+        int idle = 0;
+        while (true) {
+            bool worked = false;
+            for (size_t i = 0; i < shards.size(); i++) {
+                while (shards[i]->orders.pop(order)) {
+                    oms->submit(order, monotonicNanos());
+                    worked = true;
+                }
+            }
+            oms->process(monotonicNanos(), stamps);
+
+            if (worked) {
+                idle = 0;
+            }
+            else if (!running) {
+                oms->cancelAll();
+                break;
+            }
+            else if (oms->liveOrders() > 0) {
+                // Reports are due soon; keep polling rather than sleeping
+                std::this_thread::yield();
+            }
+            else if (++idle < 1000) {
+                std::this_thread::yield();
+            }
+            else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+    // Group commit: one flush per interval covers every fill since the last,
+    // and a snapshot goes out whenever half of the ring is uncovered
+    void journalLoop() {
+        while (running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(JOURNAL_COMMIT_INTERVAL_MS));
+            journal->commit();
+            if (journal->sinceCheckpoint() >= journal->getCapacity() / 2) accounts[0].engine.checkpoint();
+        }
+    }
+
+    // Interactive sessions rewrite one status line every second; headless
+    // ones append a [STATUS] line every HEADLESS_STATUS_SECONDS for the log
+    void displayLoop() {
+        FirmSnapshot snap;
+        int secondsSinceDump = 0;
+        int secondsSinceStatus = 0;
+        while (running) {
+            if (config.latencyDumpSeconds > 0 && ++secondsSinceDump >= config.latencyDumpSeconds) {
+                secondsSinceDump = 0;
+                std::cout << "\n";
+                printLatencyReport(latency);
+            }
+            if (config.headless && ++secondsSinceStatus < HEADLESS_STATUS_SECONDS) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+                continue;
+            }
+            secondsSinceStatus = 0;
+
+            accounts.snapshot(snap);
+            double portfolioValue = snap.firm.value;
+            double totalPnL = portfolioValue - initialCapital;
+            double returnPct = (totalPnL / initialCapital) * 100;
+
+            std::cout << (config.headless ? "[STATUS] " : "\r") << Color::BOLD << "Portfolio: $"
+                << std::fixed << std::setprecision(2) << portfolioValue
+                << " | P&L: ";
+
+            if (totalPnL >= 0) {
+                std::cout << Color::GREEN << "+$" << totalPnL << " (+" << std::setprecision(1) << returnPct << "%)";
+            }
+            else {
+                std::cout << Color::RED << "$" << totalPnL << " (" << std::setprecision(1) << returnPct << "%)";
+            }
+
+            std::cout << Color::RESET << " | Trades: " << snap.firm.trades
+                << " | Open: " << snap.firm.openPositions
+                << (config.headless ? "\n" : "     ") << std::flush;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        }
+    }
+
+public:
+    HFTSystem(const SymbolTable& syms, const SystemConfig& cfg, const TickFile* replay, FeedHandler* feed,
+        WriteAheadJournal* wal)
+        : symbols(syms), config(cfg), feedHandler(feed), journal(wal),
+        accounts(syms, cfg.risk, cfg.capital, cfg.accountWeights), runner(!cfg.virtualStrategies, cfg.tuning),
+        running(false), placementFailed(false),
+        entryPrices(syms.size(), 0.0), initialCapital(cfg.capital), warmStarted(false) {
+        uint32_t seed = config.seed != 0 ? config.seed : std::random_device{}();
+        dataProvider = std::make_unique<MarketDataProvider>(symbols, seed, config.historyWindow, config.generator);
+        dataProvider->setTickInterval(config.tickIntervalNanos);
+        if (replay != nullptr) dataProvider->setReplay(replay, config.replaySpeed);
+        if (feed != nullptr) dataProvider->setFeed(feed);
+        if (config.orderBooks) {
+            dataProvider->enableBooks(config.bookLevels);
+            // A matching venue walks the book itself; the engine books its fills as reported
+            if (config.gateway.model == GatewayModel::Simple) accounts.setDepth(dataProvider->getBooks());
+        }
+
+        logger = std::make_unique<AsyncLogger>(symbols, runner.getNames(), config.logLevel, config.logFile);
+        accounts.setLogger(logger.get());
+        // main only journals a single account
+        accounts[0].engine.setJournal(journal);
+
+        gateway = makeGateway(*dataProvider, config.gateway, symbols.size(), seed);
+        oms = std::make_unique<OrderManager>(*gateway, accounts, runner, symbols.size());
+        oms->setLogger(logger.get());
+
+        size_t shardCount = std::max<size_t>(1, config.shardCount);
+        for (size_t i = 0; i < shardCount; i++) {
+            latency.push_back(std::make_unique<ThreadLatency>());
+            shards.push_back(std::make_unique<TradingShard>(i, config.waitPolicy,
+                runner.size(), runner.getNames().size(), latency.back().get()));
+        }
+        latency.push_back(std::make_unique<ThreadLatency>());
+
+        for (SymbolId id = 0; id < symbols.size(); id++) {
+            dataProvider->route(id, &shards[id % shardCount]->ticks);
+        }
+    }
+
+    void start() {
+        std::cout << Color::BOLD << Color::GREEN;
+        std::cout << "\n============================================================\n";
+        std::cout << "     ULTRA-EFFICIENT HFT SYSTEM - PROFITABLE EDITION        \n";
+        std::cout << "============================================================\n";
+        std::cout << Color::RESET << "\n";
+
+        std::cout << Color::CYAN << "[INIT] Starting with $"
+            << std::fixed << std::setprecision(2) << initialCapital << " capital\n" << Color::RESET;
+        if (accounts.size() > 1) {
+            std::cout << Color::CYAN << "[INIT] Accounts: " << accounts.size() << " by symbol group (";
+            for (size_t i = 0; i < accounts.size(); i++) {
+                std::cout << (i == 0 ? "" : ", ") << accounts[i].name << " $" << accounts[i].capital;
+            }
+            std::cout << ")\n" << Color::RESET;
+        }
+        std::cout << Color::CYAN << "[INIT] Initializing market data for "
+            << symbols.size() << " stocks...\n" << Color::RESET;
+
+        // Opened here rather than at construction so a warm start can read
+        // last session's recording before this one truncates it
+        if (!config.recordFile.empty()) {
+            recorder = std::make_unique<TickRecorder>(config.recordFile, symbols);
+            dataProvider->setRecorder(recorder.get());
+        }
+        calibrateCycleCounter();
+        dataProvider->start();
+        if (config.placement.enabled()) {
+            place("main", currentThreadHandle(), config.placement.housekeepingCpu, false);
+            place("feed", dataProvider->getFeedThread().native_handle(), config.placement.feedCpu, true);
+        }
+
+        std::cout << Color::CYAN << "[INIT] Gateway: " << gateway->describe() << "\n" << Color::RESET;
+        if (config.orderBooks) {
+            std::cout << Color::CYAN << "[INIT] Order books: " << config.bookLevels
+                << " synthetic levels per side, fills walk the book\n" << Color::RESET;
+        }
+        std::cout << Color::CYAN << "[INIT] Tick dispatch: " << shards.size() << " shard(s), "
+            << waitPolicyName(config.waitPolicy) << " wait policy\n" << Color::RESET;
+        if (feedHandler != nullptr) {
+            std::cout << Color::CYAN << "[INIT] Feed: " << feedHandler->describe() << "\n" << Color::RESET;
+        }
+        else if (config.replayFile.empty()) {
+            std::cout << Color::CYAN << "[INIT] Feed: " << feedGeneratorName(config.generator)
+                << " generator, " << config.tickIntervalNanos / 1000 << " us step"
+                << (config.tickIntervalNanos == 0 ? " (flat out)" : "") << "\n" << Color::RESET;
+        }
+        if (!config.metricsAddress.empty()) {
+            metrics = std::make_unique<MetricsServer>(*this);
+            std::string error;
+            if (metrics->start(config.metricsAddress, error)) {
+                std::cout << Color::CYAN << "[INIT] Metrics: " << metrics->describe() << "\n" << Color::RESET;
+            }
+            else {
+                std::cout << Color::RED << "[INIT] Metrics endpoint disabled: " << error << "\n" << Color::RESET;
+                metrics.reset();
+            }
+        }
+        if (!warmStarted) {
+            // The live feed has to refill every symbol's history first
+            std::cout << Color::CYAN << "[INIT] Warming up algorithms...\n" << Color::RESET;
+            std::this_thread::sleep_for(std::chrono::seconds(3));
+        }
+
+        std::cout << Color::GREEN << "[READY] System ready - starting trading!\n" << Color::RESET;
+        std::cout << Color::BOLD << "\nActive Strategies:\n" << Color::RESET;
+        for (size_t i = 0; i < runner.size(); i++) {
+            std::cout << "  - " << Color::MAGENTA << runner.getNames()[i] << Color::RESET << "\n";
+        }
+
+        running = true;
+        logger->start();
+        executionThread = std::thread(&HFTSystem::executionLoop, this);
+        for (size_t i = 0; i < shards.size(); i++) {
+            shards[i]->thread = std::thread(&HFTSystem::shardLoop, this, shards[i].get());
+        }
+        if (config.placement.enabled()) {
+            place("logger", logger->getWriterThread().native_handle(), config.placement.housekeepingCpu, false);
+            for (size_t i = 0; i < shards.size(); i++) {
+                place("shard " + std::to_string(i), shards[i]->thread.native_handle(),
+                    config.placement.tradingCpu(i), true);
+            }
+            place("execution", executionThread.native_handle(), config.placement.tradingCpu(shards.size()), true);
+        }
+        printPlacement();
+
+        std::cout << "\n" << Color::YELLOW << (config.headless ? "Running headless; SIGINT or SIGTERM stops the session\n\n"
+            : "Press ENTER to stop...\n\n") << Color::RESET;
+        displayThread = std::thread(&HFTSystem::displayLoop, this);
+        if (journal != nullptr) journalThread = std::thread(&HFTSystem::journalLoop, this);
+        if (config.placement.enabled()) {
+            std::string line;
+            placeThread("display", displayThread.native_handle(), config.placement.housekeepingCpu, false,
+                config.placement, line);
+        }
+        if (metrics && config.placement.enabled()) {
+            std::string line;
+            placeThread("metrics", metrics->getThread().native_handle(), config.placement.housekeepingCpu, false,
+                config.placement, line);
+        }
+    }
+
+    // Exporter thread. Every value below is an atomic owned by the thread
+    // that writes it, so a scrape never takes a lock the trading path uses.
+    void writeMetrics(std::ostream& out) const override {
+        out << std::setprecision(10);
+        writeMetricHeader(out, "hft_ticks_published_total", "counter", "Quotes the feed published");
+        out << "hft_ticks_published_total " << dataProvider->getPublished() << '\n';
+
+        writeMetricHeader(out, "hft_ticks_processed_total", "counter", "Ticks each shard has handled");
+        for (size_t i = 0; i < shards.size(); i++) {
+            out << "hft_ticks_processed_total{shard=\"" << i << "\"} " << shards[i]->ticksProcessed.get() << '\n';
+        }
+        writeMetricHeader(out, "hft_ticks_dropped_total", "counter", "Ticks dropped because a shard queue was full");
+        for (size_t i = 0; i < shards.size(); i++) {
+            out << "hft_ticks_dropped_total{shard=\"" << i << "\"} " << shards[i]->ticks.getDropped() << '\n';
+        }
+        writeMetricHeader(out, "hft_tick_queue_depth", "gauge", "Ticks waiting in each shard queue");
+        for (size_t i = 0; i < shards.size(); i++) {
+            out << "hft_tick_queue_depth{shard=\"" << i << "\"} " << shards[i]->ticks.depth() << '\n';
+        }
+        writeMetricHeader(out, "hft_order_queue_depth", "gauge", "Orders waiting for the sequencer in each shard queue");
+        for (size_t i = 0; i < shards.size(); i++) {
+            out << "hft_order_queue_depth{shard=\"" << i << "\"} " << shards[i]->orders.size() << '\n';
+        }
+        writeMetricHeader(out, "hft_orders_dropped_total", "counter", "Approved orders dropped on a full order queue");
+        for (size_t i = 0; i < shards.size(); i++) {
+            out << "hft_orders_dropped_total{shard=\"" << i << "\"} " << shards[i]->ordersDropped.get() << '\n';
+        }
+
+        const std::vector<std::string>& names = runner.getNames();
+        writeMetricHeader(out, "hft_orders_proposed_total", "counter", "Orders each strategy proposed, before risk checks");
+        for (size_t j = 0; j < names.size(); j++) {
+            uint64_t total = 0;
+            for (size_t i = 0; i < shards.size(); i++) total += shards[i]->ordersProposed[j].get();
+            out << "hft_orders_proposed_total{strategy=\"" << escapeLabel(names[j]) << "\"} " << total << '\n';
+        }
+        writeMetricHeader(out, "hft_risk_verdicts_total", "counter", "Risk gate decisions by outcome");
+        for (int v = 0; v < RISK_VERDICT_COUNT; v++) {
+            out << "hft_risk_verdicts_total{verdict=\"" << riskVerdictName(v) << "\"} "
+                << accounts.getVerdicts(static_cast<RiskVerdict>(v)) << '\n';
+        }
+
+        const OrderCounters& orders = oms->getCounters();
+        writeMetricHeader(out, "hft_oms_events_total", "counter", "Order manager events by kind");
+        out << "hft_oms_events_total{event=\"submitted\"} " << orders.submitted.get() << '\n'
+            << "hft_oms_events_total{event=\"acked\"} " << orders.acked.get() << '\n'
+            << "hft_oms_events_total{event=\"filled\"} " << orders.fills.get() << '\n'
+            << "hft_oms_events_total{event=\"partially_filled\"} " << orders.partialFills.get() << '\n'
+            << "hft_oms_events_total{event=\"rejected\"} " << orders.rejected.get() << '\n'
+            << "hft_oms_events_total{event=\"cancelled\"} " << orders.cancelled.get() << '\n';
+
+        FirmSnapshot snap;
+        accounts.snapshot(snap);
+        writeMetricHeader(out, "hft_portfolio_value", "gauge", "Cash plus open positions at their last marks");
+        out << "hft_portfolio_value " << snap.firm.value << '\n';
+        writeMetricHeader(out, "hft_cash", "gauge", "Cash on hand");
+        out << "hft_cash " << snap.firm.cash << '\n';
+        writeMetricHeader(out, "hft_exposure", "gauge", "Market value of open positions");
+        out << "hft_exposure " << snap.firm.exposure() << '\n';
+        writeMetricHeader(out, "hft_pnl", "gauge", "Profit and loss since the session started");
+        out << "hft_pnl{kind=\"realized\"} " << snap.firm.realizedPnL << '\n'
+            << "hft_pnl{kind=\"unrealized\"} " << snap.firm.unrealizedPnL << '\n';
+        writeMetricHeader(out, "hft_open_positions", "gauge", "Symbols with a position open");
+        out << "hft_open_positions " << snap.firm.openPositions << '\n';
+        writeMetricHeader(out, "hft_trades_total", "counter", "Fills booked by the engine");
+        out << "hft_trades_total " << snap.firm.trades << '\n';
+        if (accounts.size() > 1) {
+            writeMetricHeader(out, "hft_account_value", "gauge", "Each sub-account's cash plus open positions");
+            for (size_t i = 0; i < accounts.size(); i++) {
+                out << "hft_account_value{account=\"" << accounts[i].name << "\"} " << snap.accounts[i].value << '\n';
+            }
+            writeMetricHeader(out, "hft_account_cash", "gauge", "Each sub-account's cash on hand");
+            for (size_t i = 0; i < accounts.size(); i++) {
+                out << "hft_account_cash{account=\"" << accounts[i].name << "\"} " << snap.accounts[i].cash << '\n';
+            }
+            writeMetricHeader(out, "hft_account_exposure", "gauge", "Each sub-account's open position value");
+            for (size_t i = 0; i < accounts.size(); i++) {
+                out << "hft_account_exposure{account=\"" << accounts[i].name << "\"} " << snap.accounts[i].exposure()
+                    << '\n';
+            }
+            writeMetricHeader(out, "hft_account_pnl", "gauge", "Each sub-account's profit and loss against its capital");
+            for (size_t i = 0; i < accounts.size(); i++) {
+                out << "hft_account_pnl{account=\"" << accounts[i].name << "\"} " << snap.accounts[i].pnl() << '\n';
+            }
+        }
+        writeMetricHeader(out, "hft_log_records_dropped_total", "counter", "Log records dropped on a full log queue");
+        out << "hft_log_records_dropped_total " << logger->getDropped() << '\n';
+
+        writeMetricHeader(out, "hft_latency_seconds", "summary", "Pipeline stage latency across all threads");
+        for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+            LatencySnapshot snap;
+            for (size_t t = 0; t < latency.size(); t++) snap.merge(latency[t]->stages[stage]);
+            const double quantiles[] = { 0.5, 0.99, 0.999 };
+            for (double q : quantiles) {
+                out << "hft_latency_seconds{stage=\"" << latencyStageKey(stage) << "\",quantile=\"" << q << "\"} "
+                    << snap.percentile(q * 100.0) / 1e9 << '\n';
+            }
+            out << "hft_latency_seconds_count{stage=\"" << latencyStageKey(stage) << "\"} " << snap.total << '\n';
+        }
+    }
+
+    // Before start(): seeds the market state from a tick recording, usually
+    // the previous session's --record file. The warm-up pause is skipped
+    // once every symbol has enough history to trade.
+    void warmStart(const TickFile& file, const std::string& path) {
+        int64_t startNanos = monotonicNanos();
+        size_t ready = 0;
+        size_t applied = dataProvider->warmStart(file, ready);
+        warmStarted = ready == symbols.size();
+        std::cout << Color::CYAN << "[INIT] Warm start: " << applied << " ticks from " << path << " in "
+            << std::fixed << std::setprecision(2) << (monotonicNanos() - startNanos) / 1e6 << " ms, "
+            << ready << "/" << symbols.size() << " symbols ready to trade\n" << Color::RESET;
+    }
+
+    // Before start(): a journal that has traded before restores the account,
+    // a new one records the starting capital
+    bool recoverJournal(std::string& error) {
+        if (journal == nullptr) return true;
+        if (!journal->hasState()) {
+            journal->begin(initialCapital);
+            std::cout << Color::CYAN << "[INIT] Journal: " << journal->getPath() << " (new, "
+                << journal->getCapacity() << " record ring)\n" << Color::RESET;
+            return true;
+        }
+        int64_t startNanos = monotonicNanos();
+        TradingEngine& engine = accounts[0].engine;
+        uint64_t replayed = engine.recover(error);
+        if (!error.empty()) return false;
+        initialCapital = journal->getInitialCapital();
+        std::cout << Color::CYAN << "[INIT] Journal: recovered " << engine.getOpenPositions()
+            << " open positions and $" << std::fixed << std::setprecision(2) << engine.getCash()
+            << " cash from " << journal->getPath() << " (snapshot + " << replayed << " records in "
+            << std::setprecision(2) << (monotonicNanos() - startNanos) / 1e6 << " ms)\n" << Color::RESET;
+        return true;
+    }
+
+    void printPlacement() const {
+        if (!config.placement.enabled()) {
+            std::cout << Color::CYAN << "[INIT] Thread placement: OS default\n" << Color::RESET;
+            return;
+        }
+        for (size_t i = 0; i < placementLog.size(); i++) {
+            std::cout << Color::CYAN << "[INIT] Placement: " << placementLog[i] << "\n" << Color::RESET;
+        }
+        if (placementFailed) {
+            std::cout << Color::YELLOW << "[INIT] Some placement requests failed; realtime scheduling "
+                "usually needs CAP_SYS_NICE or an rtprio limit\n" << Color::RESET;
+        }
+    }
+
+    void stop() {
+        std::cout << "\n\n" << Color::YELLOW << "[STOP] Shutting down trading engine...\n"
+            << Color::RESET;
+        running = false;
+        // The feed goes first so nothing is routed to a shard that has exited
+        dataProvider->stop();
+        for (size_t i = 0; i < shards.size(); i++) {
+            shards[i]->ticks.wake();
+            if (shards[i]->thread.joinable()) shards[i]->thread.join();
+        }
+        // The sequencer drains whatever the shards submitted before exiting
+        if (executionThread.joinable()) executionThread.join();
+        if (journalThread.joinable()) journalThread.join();
+        if (journal != nullptr) accounts[0].engine.checkpoint();
+        if (displayThread.joinable()) displayThread.join();
+        if (metrics) metrics->stop();
+        logger->stop();
+
+        accounts.printSummary();
+
+        ContentionStats contention = dataProvider->getContentionStats();
+        std::cout << Color::CYAN << "[STATS] Quote seqlock retries: " << contention.quoteRetries
+            << " | Feed ticks published: " << dataProvider->getPublished() << "\n" << Color::RESET;
+        if (feedHandler != nullptr) printFeedStats(feedHandler->getStats());
+
+        uint64_t processed = 0, dropped = 0, ordersDropped = 0;
+        for (size_t i = 0; i < shards.size(); i++) {
+            processed += shards[i]->ticksProcessed.get();
+            dropped += shards[i]->ticks.getDropped();
+            ordersDropped += shards[i]->ordersDropped.get();
+        }
+        std::cout << Color::CYAN << "[STATS] Ticks processed: " << processed
+            << " | Dropped: " << dropped << " | Orders rejected: " << oms->getRejected()
+            << " | Orders dropped: " << ordersDropped
+            << " | Log records dropped: " << logger->getDropped() << "\n" << Color::RESET;
+        oms->printReport();
+        accounts.printReports();
+        if (journal != nullptr) {
+            std::cout << Color::CYAN << "[JOURNAL] " << journal->getPath() << " | last record: "
+                << journal->lastSequence() << " | commits: " << journal->getCommits()
+                << " | snapshots: " << journal->getCheckpoints() << "\n" << Color::RESET;
+        }
+        if (recorder) {
+            recorder->flush();
+            printRecorderStats(*recorder, config.recordFile);
+        }
+        printLatencyReport(latency);
+#ifdef HFT_PROFILE
+        printProfileReport(runner.getNames(), processed);
+#endif
+        std::cout << Color::GREEN << "\n[COMPLETE] Session ended successfully!\n" << Color::RESET;
+    }
+};
+
+const uint32_t DEFAULT_BACKTEST_SEED = 42;
+const uint64_t DEFAULT_BACKTEST_STEPS = 20000;
+const double DEFAULT_BACKTEST_CAPITAL = 100000.0;
+const int64_t BACKTEST_EPOCH_NANOS = 1704205800LL * 1000000000LL; // 2024-01-02 14:30 UTC
+
+struct BacktestResult {
+    uint64_t ticks;
+    double seconds;
+    double finalValue;
+    double realizedPnL;
+    int trades;
+    int winningTrades;
+    int losingTrades;
+    double maxDrawdown;    // worst fall from peak portfolio value, sampled per timestamp
+    uint64_t rejected;
+    uint64_t allocations;  // heap allocations during the run, excluding journal chunks
+};
+
+// Read-only ticks that any number of backtests can replay at once: a mapped
+// tick file, or the seeded simulator's market generated into memory once
+class TickTape {
+private:
+    std::vector<TickRecord> owned;
+    const TickRecord* first;
+    size_t count;
+    std::vector<SymbolId> ids;  // record symbol index -> SymbolId
+
+public:
+    TickTape(const TickFile& file, const SymbolTable& symbols)
+        : first(file.begin()), count(file.size()), ids(file.mapSymbols(symbols)) {
+    }
+
+    TickTape(const SymbolTable& symbols, uint32_t seed, FeedGenerator generator, uint64_t steps)
+        : first(nullptr), count(0), ids(symbols.size()) {
+        GbmSimulator simulator(symbols.size(), seed, generator);
+        owned.reserve(static_cast<size_t>(steps * symbols.size()));
+        int64_t clock = BACKTEST_EPOCH_NANOS;
+        for (uint64_t step = 0; step < steps; step++) {
+            simulator.step(clock, [this](const MarketData& data) { owned.push_back(TickRecord::fromMarketData(data)); });
+            clock += TICK_INTERVAL_NANOS;
+        }
+        for (SymbolId id = 0; id < symbols.size(); id++) ids[id] = id;
+        first = owned.data();
+        count = owned.size();
+    }
+
+    const TickRecord* begin() const { return first; }
+    const TickRecord* end() const { return first + count; }
+    size_t size() const { return count; }
+
+    SymbolId map(const TickRecord& rec) const {
+        return rec.symbol < ids.size() ? ids[rec.symbol] : INVALID_SYMBOL;
+    }
+
+    TickTape(const TickTape&) = delete;
+    TickTape& operator=(const TickTape&) = delete;
+};
+
+// Drives the live StrategyRunner and TradingEngine code synchronously from
+// the seeded simulator: no threads, no sleeps, and a simulated clock that
+// advances TICK_INTERVAL_NANOS per step. The same seed and step count
+// always produce the same trades.
+class Backtester {
+private:
+    const SymbolTable& symbols;
+    SystemConfig config;
+    const TickTape* replay;
+    std::unique_ptr<TickRecorder> recorder;
+    MarketDataProvider provider;
+    AccountSet accounts;
+    StrategyRunner runner;
+    std::unique_ptr<AsyncLogger> logger;
+    std::vector<Signal> signals;
+    std::unique_ptr<ThreadLatency> stamps;
+    std::unique_ptr<ExchangeGateway> gateway;
+    OrderManager oms;
+    uint64_t ticks;
+
+    // Batch mode: ticks sharing a timestamp are published first, then one
+    // analyzeAll pass runs before each of them is decided in arrival order
+    KernelIsa isa;
+    UniverseFrame frame;
+    std::vector<SignalMask> batchBuys;
+    std::vector<SignalMask> batchSells;
+    std::vector<SymbolId> pendingSymbols;
+    std::vector<uint64_t> pendingCycles;
+    SignalMask pendingSeen;
+    int64_t pendingTimestamp;
+
+    double peakValue;
+    double maxDrawdown;
+    int64_t valueTimestamp;
+
+    void sampleDrawdown(int64_t timestamp) {
+        double value = accounts.getPortfolioValue();
+        if (value > peakValue) peakValue = value;
+        else if (peakValue > 0) maxDrawdown = std::max(maxDrawdown, (peakValue - value) / peakValue);
+        valueTimestamp = timestamp;
+    }
+
+    void onTick(const MarketData& data) {
+        if (!config.batchSignals) {
+            if (data.timestamp != valueTimestamp) sampleDrawdown(data.timestamp);
+            provider.publish(data);
+            oms.process(data.timestamp, *stamps);
+            ticks++;
+            handle(data.symbol, cycleCounter(), nullptr);
+            return;
+        }
+
+        if (!pendingSymbols.empty() && (data.timestamp != pendingTimestamp || pendingSeen.test(data.symbol))) {
+            flushBatch();
+        }
+        if (data.timestamp != valueTimestamp) sampleDrawdown(data.timestamp);
+        provider.publish(data);
+        oms.process(data.timestamp, *stamps);
+        ticks++;
+        pendingSymbols.push_back(data.symbol);
+        pendingCycles.push_back(cycleCounter());
+        pendingSeen.set(data.symbol);
+        pendingTimestamp = data.timestamp;
+    }
+
+    void flushBatch() {
+        if (pendingSymbols.empty()) return;
+
+        uint64_t batchStart = cycleCounter();
+        provider.snapshot(frame);
+        runner.analyzeAll(frame, isa, batchBuys, batchSells);
+        stamps->record(STAGE_BATCH_SIGNALS, batchStart, cycleCounter());
+
+        for (size_t k = 0; k < pendingSymbols.size(); k++) {
+            handle(pendingSymbols[k], pendingCycles[k], &batchBuys);
+        }
+        pendingSymbols.clear();
+        pendingCycles.clear();
+        pendingSeen.clear();
+    }
+
+    // Orders go through the same OMS as live trading; with the default
+    // gateway they are filled before the submit returns
+    void handle(SymbolId symbol, uint64_t publishCycles, const std::vector<SignalMask>* batch) {
+        OrderRequest order;
+        Account& account = accounts.forSymbol(symbol);
+        if (!oms.isInFlight(symbol) &&
+            runner.decide(provider, account.engine, account.gate, symbol, publishCycles, signals, *stamps, order, batch)) {
+            uint64_t riskStart = cycleCounter();
+            RiskVerdict verdict = account.gate.approve(order, account.engine);
+            stamps->record(STAGE_RISK, riskStart, cycleCounter());
+
+            if (verdict == RISK_APPROVED) {
+                oms.submit(order, order.timestamp);
+                oms.process(order.timestamp, *stamps);
+            }
+        }
+        stamps->record(STAGE_TICK_TO_DECISION, publishCycles, cycleCounter());
+    }
+
+public:
+    Backtester(const SymbolTable& syms, const SystemConfig& cfg, const TickTape* source)
+        : symbols(syms), config(cfg), replay(source),
+        provider(syms, cfg.seed != 0 ? cfg.seed : DEFAULT_BACKTEST_SEED, cfg.historyWindow, cfg.generator),
+        accounts(syms, cfg.risk, cfg.capital, cfg.accountWeights), runner(!cfg.virtualStrategies, cfg.tuning),
+        signals(runner.size()),
+        stamps(std::make_unique<ThreadLatency>()),
+        gateway(makeGateway(provider, cfg.gateway, syms.size(), cfg.seed != 0 ? cfg.seed : DEFAULT_BACKTEST_SEED)),
+        oms(*gateway, accounts, runner, syms.size()), ticks(0),
+        isa(cfg.allowSimd ? detectKernelIsa() : KernelIsa::Scalar), frame(syms.size()),
+        batchBuys(runner.size(), SignalMask(syms.size())), batchSells(runner.size(), SignalMask(syms.size())),
+        pendingSeen(syms.size()), pendingTimestamp(0), peakValue(cfg.capital), maxDrawdown(0.0),
+        valueTimestamp(0) {
+        pendingSymbols.reserve(syms.size());
+        pendingCycles.reserve(syms.size());
+        // Fills are only journaled when a log file is requested; printing
+        // every simulated fill to the console would dominate the run time
+        if (!config.logFile.empty()) {
+            logger = std::make_unique<AsyncLogger>(symbols, runner.getNames(), config.logLevel, config.logFile);
+            accounts.setLogger(logger.get());
+            oms.setLogger(logger.get());
+        }
+        if (!config.recordFile.empty()) {
+            recorder = std::make_unique<TickRecorder>(config.recordFile, symbols);
+            provider.setRecorder(recorder.get());
+        }
+        if (config.orderBooks) {
+            provider.enableBooks(config.bookLevels);
+            if (config.gateway.model == GatewayModel::Simple) accounts.setDepth(provider.getBooks());
+        }
+    }
+
+    // Callers calibrate the cycle counter once beforehand
+    BacktestResult run() {
+        if (logger) logger->start();
+
+#ifdef HFT_COUNT_ALLOCS
+        uint64_t allocsBefore = heapAllocations.load();
+        size_t chunksBefore = accounts.getJournalChunks();
+#endif
+        int64_t startNanos = monotonicNanos();
+        if (replay != nullptr) {
+            // Replays the whole file; the recorded timestamps are the clock
+            for (const TickRecord* rec = replay->begin(); rec != replay->end(); ++rec) {
+                SymbolId id = replay->map(*rec);
+                if (id != INVALID_SYMBOL) onTick(rec->toMarketData(id));
+            }
+        }
+        else {
+            GbmSimulator& simulator = provider.getSimulator();
+            int64_t clock = BACKTEST_EPOCH_NANOS;
+            for (uint64_t step = 0; step < config.backtestSteps; step++) {
+                simulator.step(clock, [this](const MarketData& data) { onTick(data); });
+                clock += TICK_INTERVAL_NANOS;
+            }
+        }
+        flushBatch();
+        oms.cancelAll();
+        sampleDrawdown(valueTimestamp);
+        double seconds = (monotonicNanos() - startNanos) / 1e9;
+
+        BacktestResult result;
+        result.allocations = 0;
+#ifdef HFT_COUNT_ALLOCS
+        result.allocations = heapAllocations.load() - allocsBefore
+            - (accounts.getJournalChunks() - chunksBefore);
+#endif
+
+        if (logger) logger->stop();
+        if (recorder) recorder->flush();
+
+        result.ticks = ticks;
+        result.seconds = seconds;
+        FirmSnapshot snap;
+        accounts.snapshot(snap);
+        result.finalValue = snap.firm.value;
+        result.realizedPnL = snap.firm.realizedPnL;
+        result.trades = snap.firm.trades;
+        result.winningTrades = accounts.getWinningTrades();
+        result.losingTrades = accounts.getLosingTrades();
+        result.maxDrawdown = maxDrawdown;
+        result.rejected = oms.getRejected();
+        return result;
+    }
+
+    void printReport() {
+        accounts.printSummary();
+        oms.printReport();
+        accounts.printReports();
+        if (recorder) printRecorderStats(*recorder, config.recordFile);
+        std::vector<std::unique_ptr<ThreadLatency>> report;
+        report.push_back(std::move(stamps));
+        printLatencyReport(report);
+        stamps = std::move(report[0]);
+#ifdef HFT_PROFILE
+        printProfileReport(runner.getNames(), ticks);
+#endif
+    }
+};
+
+int runBacktest(const SymbolTable& symbols, const SystemConfig& config, const TickFile* replay) {
+    uint32_t seed = config.seed != 0 ? config.seed : DEFAULT_BACKTEST_SEED;
+
+    if (replay != nullptr) {
+        std::cout << Color::CYAN << "[BACKTEST] Replaying " << replay->size() << " ticks from "
+            << config.replayFile << ", $" << std::fixed << std::setprecision(2) << config.capital
+            << " capital\n" << Color::RESET;
+    }
+    else {
+        std::cout << Color::CYAN << "[BACKTEST] " << config.backtestSteps << " steps x "
+            << symbols.size() << " symbols, seed " << seed << ", $"
+            << std::fixed << std::setprecision(2) << config.capital << " capital\n" << Color::RESET;
+    }
+
+    if (config.virtualStrategies) {
+        std::cout << Color::CYAN << "[BACKTEST] Strategies dispatched through TradingStrategy\n" << Color::RESET;
+    }
+    if (config.batchSignals) {
+        KernelIsa isa = config.allowSimd ? detectKernelIsa() : KernelIsa::Scalar;
+        std::cout << Color::CYAN << "[BACKTEST] Batch signals with " << kernelIsaName(isa)
+            << " kernels\n" << Color::RESET;
+    }
+    if (config.orderBooks) {
+        std::cout << Color::CYAN << "[BACKTEST] Fills walk " << config.bookLevels
+            << "-level synthetic books\n" << Color::RESET;
+    }
+    if (config.accountWeights.size() > 1) {
+        std::cout << Color::CYAN << "[BACKTEST] Capital split across " << config.accountWeights.size()
+            << " sub-accounts by symbol group\n" << Color::RESET;
+    }
+
+    // The backtest is single-threaded: it runs on the first trading CPU, and
+    // pinning before construction keeps its state on that CPU's node
+    if (config.placement.enabled()) {
+        std::string line;
+        bool placed = placeThread("backtest", currentThreadHandle(), config.placement.tradingCpu(0), true,
+            config.placement, line);
+        std::cout << (placed ? Color::CYAN : Color::YELLOW) << "[BACKTEST] Placement: " << line
+            << "\n" << Color::RESET;
+    }
 
+    calibrateCycleCounter();
+    std::unique_ptr<TickTape> tape;
+    if (replay != nullptr) tape = std::make_unique<TickTape>(*replay, symbols);
+    Backtester backtester(symbols, config, tape.get());
+    BacktestResult result = backtester.run();
+    backtester.printReport();
+
+    double rate = result.seconds > 0 ? result.ticks / result.seconds : 0.0;
+    std::cout << Color::CYAN << "[BACKTEST] " << result.ticks << " ticks in "
+        << std::setprecision(3) << result.seconds << "s ("
+        << std::setprecision(0) << rate << " ticks/sec) | Rejected: " << result.rejected
+        << "\n" << Color::RESET;
+    std::cout << Color::CYAN << "[BACKTEST] Max drawdown: " << std::setprecision(2)
+        << result.maxDrawdown * 100 << "%\n" << Color::RESET;
+    std::cout << Color::CYAN << "[BACKTEST] Fingerprint: value=" << std::setprecision(2)
+        << result.finalValue << " trades=" << result.trades << "\n" << Color::RESET;
+#ifdef HFT_COUNT_ALLOCS
+    const std::string& allocColor = result.allocations == 0 ? Color::GREEN : Color::RED;
+    std::cout << allocColor << "[BACKTEST] Steady-state heap allocations: " << result.allocations
+        << "\n" << Color::RESET;
+    if (result.allocations != 0) return 1;
+#endif
+    return 0;
+}
+
+// Scaling runs hold the tick count near SCALING_TICK_BUDGET so per-tick cost
+// is comparable across universe sizes; small universes just run more steps
+const uint64_t SCALING_TICK_BUDGET = 2000000;
+const uint64_t MIN_SCALING_STEPS = 200;  // enough to fill the default history window
+const std::vector<size_t> DEFAULT_SCALING_SIZES = { 100, 1000, 10000, 100000 };
+
+bool parseSizeList(const std::string& text, std::vector<size_t>& sizes) {
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || value == 0 || value > MAX_UNIVERSE_SIZE) return false;
+        sizes.push_back(static_cast<size_t>(value));
+    }
+    return !sizes.empty();
+}
+
+int runScalingBench(const SystemConfig& config, const std::vector<size_t>& sizes) {
+    std::cout << Color::CYAN << "[SCALING] Synthetic universes, ~" << SCALING_TICK_BUDGET
+        << " ticks each, " << feedGeneratorName(config.generator) << " generator"
+        << (config.batchSignals ? ", batch signals" : "") << "\n" << Color::RESET;
+    calibrateCycleCounter();
+    std::cout << std::right << std::setw(10) << "Symbols" << std::setw(10) << "Steps"
+        << std::setw(12) << "Ticks" << std::setw(12) << "Setup ms" << std::setw(12) << "ns/tick"
+        << std::setw(14) << "Ticks/sec" << std::setw(10) << "Trades" << "\n";
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        SymbolTable symbols(syntheticSymbols(sizes[i]));
+        SystemConfig run = config;
+        run.backtestSteps = std::max<uint64_t>(MIN_SCALING_STEPS, SCALING_TICK_BUDGET / sizes[i]);
+
+        int64_t setupStart = monotonicNanos();
+        Backtester backtester(symbols, run, nullptr);
+        double setupMs = (monotonicNanos() - setupStart) / 1e6;
+        BacktestResult result = backtester.run();
+
+        double nsPerTick = result.ticks > 0 ? result.seconds * 1e9 / result.ticks : 0.0;
+        double rate = result.seconds > 0 ? result.ticks / result.seconds : 0.0;
+        std::cout << std::setw(10) << sizes[i] << std::setw(10) << run.backtestSteps
+            << std::setw(12) << result.ticks << std::fixed << std::setprecision(1)
+            << std::setw(12) << setupMs << std::setw(12) << nsPerTick
+            << std::setprecision(0) << std::setw(14) << rate << std::setw(10) << result.trades
+            << "\n" << std::flush;
+    }
+    return 0;
+}
+
+// Publishes the simulated universe to a UDP address until ENTER is pressed
+int runFeedPublisher(const SymbolTable& symbols, const SystemConfig& config, const std::string& url) {
+    FeedEndpoint endpoint;
+    std::string error;
+    uint32_t seed = config.seed != 0 ? config.seed : std::random_device{}();
+    if (!parseFeedEndpoint(url, endpoint, error)) {
+        std::cout << Color::RED << "Cannot publish to " << url << ": " << error << "\n" << Color::RESET;
+        return 1;
+    }
+    FeedPublisher publisher(symbols, endpoint, seed, config.generator, config.tickIntervalNanos);
+    if (!publisher.open(error)) {
+        std::cout << Color::RED << "Cannot publish to " << url << ": " << error << "\n" << Color::RESET;
+        return 1;
+    }
+    std::cout << Color::CYAN << "[FEED] Publishing " << symbols.size() << " symbols to " << url << " ("
+        << feedGeneratorName(config.generator) << " generator, " << config.tickIntervalNanos / 1000
+        << " us step)\n" << Color::RESET;
+    std::cout << Color::YELLOW << "Press ENTER to stop\n" << Color::RESET;
+
+    int64_t startNanos = monotonicNanos();
+    publisher.start();
     std::cin.get();
+    publisher.stop();
+    double seconds = (monotonicNanos() - startNanos) / 1e9;
+
+    std::cout << Color::CYAN << "[FEED] Sent " << publisher.getPackets() << " packets, "
+        << publisher.getQuotes() << " quotes (" << std::fixed << std::setprecision(0)
+        << publisher.getQuotes() / std::max(seconds, 1e-9) << " quotes/sec), send errors: "
+        << publisher.getSendErrors() << "\n" << Color::RESET;
+    return 0;
+}
+
+// bench.cpp includes this file with HFT_NO_MAIN defined to reuse everything above
+#ifndef HFT_NO_MAIN
+// One dimension of a parameter sweep: explicit values, or low:high:step
+// expanded to a grid (random search draws uniformly from low..high instead)
+struct SweepAxis {
+    const TuningField* field;
+    std::vector<double> values;
+    double low;
+    double high;
+    bool range;
+};
+
+enum class SweepRank { PnL, WinRate, Drawdown };
+
+struct SweepOptions {
+    std::vector<SweepAxis> axes;
+    size_t randomPoints;  // 0 runs the full grid
+    size_t threads;
+    size_t top;
+    SweepRank rank;
+
+    SweepOptions() : randomPoints(0), threads(std::max<size_t>(1, std::thread::hardware_concurrency())),
+        top(10), rank(SweepRank::PnL) {
+    }
+};
+
+const size_t MAX_SWEEP_POINTS = 100000;
+
+// NAME=low:high:step, NAME=low:high (random search only) or NAME=v1,v2,...
+bool parseSweepAxis(const std::string& text, SweepAxis& axis, std::string& error) {
+    size_t eq = text.find('=');
+    std::string name = text.substr(0, eq);
+    axis.field = findTuningField(name);
+    if (axis.field == nullptr) {
+        error = "unknown parameter '" + name + "' (expected one of " + tuningFieldNames() + ")";
+        return false;
+    }
+    if (eq == std::string::npos || eq + 1 == text.size()) {
+        error = "no values for " + name;
+        return false;
+    }
+    std::string spec = text.substr(eq + 1);
+    axis.range = spec.find(':') != std::string::npos;
+    std::vector<double> numbers;
+    std::stringstream in(spec);
+    std::string item;
+    while (std::getline(in, item, axis.range ? ':' : ',')) {
+        char* end = nullptr;
+        double value = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0') {
+            error = "bad number '" + item + "' for " + name;
+            return false;
+        }
+        numbers.push_back(value);
+    }
+    if (!axis.range) {
+        axis.values = numbers;
+        axis.low = *std::min_element(numbers.begin(), numbers.end());
+        axis.high = *std::max_element(numbers.begin(), numbers.end());
+        return true;
+    }
+    if (numbers.size() < 2 || numbers.size() > 3 || numbers[1] < numbers[0]) {
+        error = "expected low:high[:step] for " + name;
+        return false;
+    }
+    axis.low = numbers[0];
+    axis.high = numbers[1];
+    if (numbers.size() == 3) {
+        double step = numbers[2];
+        if (step <= 0 || (axis.high - axis.low) / step >= MAX_SWEEP_POINTS) {
+            error = "bad step for " + name;
+            return false;
+        }
+        size_t steps = static_cast<size_t>((axis.high - axis.low) / step + 1e-9);
+        for (size_t k = 0; k <= steps; k++) axis.values.push_back(axis.low + k * step);
+    }
+    return true;
+}
+
+bool parseSweepRank(const std::string& text, SweepRank& rank) {
+    if (text == "pnl") rank = SweepRank::PnL;
+    else if (text == "winrate") rank = SweepRank::WinRate;
+    else if (text == "drawdown") rank = SweepRank::Drawdown;
+    else return false;
+    return true;
+}
+
+inline double winRate(const BacktestResult& r) {
+    int closed = r.winningTrades + r.losingTrades;
+    return closed > 0 ? static_cast<double>(r.winningTrades) / closed : 0.0;
+}
+
+// Runs one backtest per parameter point over a single shared TickTape. Every
+// worker owns its Backtester (provider, engine, strategies, risk gate), so
+// the only shared state is the read-only tape.
+int runSweep(const SymbolTable& symbols, const SystemConfig& config, const TickFile* replay,
+    const SweepOptions& options) {
+    std::vector<std::vector<double>> points;
+    if (options.randomPoints > 0) {
+        std::mt19937_64 gen(config.seed != 0 ? config.seed : DEFAULT_BACKTEST_SEED);
+        for (size_t n = 0; n < options.randomPoints; n++) {
+            std::vector<double> point;
+            for (const SweepAxis& axis : options.axes) {
+                if (!axis.values.empty() && !axis.range) {
+                    point.push_back(axis.values[gen() % axis.values.size()]);
+                }
+                else {
+                    point.push_back(std::uniform_real_distribution<double>(axis.low, axis.high)(gen));
+                }
+            }
+            points.push_back(point);
+        }
+    }
+    else {
+        size_t total = 1;
+        for (const SweepAxis& axis : options.axes) {
+            if (axis.values.empty()) {
+                std::cout << Color::RED << "A grid sweep needs a step for " << axis.field->name
+                    << " (or use --sweep-random=N)\n" << Color::RESET;
+                return 1;
+            }
+            total *= axis.values.size();
+            if (total > MAX_SWEEP_POINTS) {
+                std::cout << Color::RED << "Sweep grid exceeds " << MAX_SWEEP_POINTS << " points\n" << Color::RESET;
+                return 1;
+            }
+        }
+        for (size_t n = 0; n < total; n++) {
+            std::vector<double> point;
+            size_t rest = n;
+            for (const SweepAxis& axis : options.axes) {
+                point.push_back(axis.values[rest % axis.values.size()]);
+                rest /= axis.values.size();
+            }
+            points.push_back(point);
+        }
+    }
+
+    calibrateCycleCounter();
+    uint32_t seed = config.seed != 0 ? config.seed : DEFAULT_BACKTEST_SEED;
+    std::unique_ptr<TickTape> tape;
+    if (replay != nullptr) tape = std::make_unique<TickTape>(*replay, symbols);
+    else tape = std::make_unique<TickTape>(symbols, seed, config.generator, config.backtestSteps);
+
+    size_t threads = std::min(options.threads, points.size());
+    std::cout << Color::CYAN << "[SWEEP] " << points.size() << (options.randomPoints > 0 ? " random" : " grid")
+        << " points x " << tape->size() << " ticks on " << threads << " thread(s), $"
+        << std::fixed << std::setprecision(2) << config.capital << " capital\n" << Color::RESET;
+
+    std::vector<BacktestResult> results(points.size());
+    std::atomic<size_t> next(0);
+    auto worker = [&](size_t index) {
+        std::string line;
+        int cpu = config.placement.tradingCpu(index);
+        if (cpu >= 0) placeThread("sweep", currentThreadHandle(), cpu, true, config.placement, line);
+        for (size_t n = next.fetch_add(1); n < points.size(); n = next.fetch_add(1)) {
+            SystemConfig run = config;
+            run.logFile.clear();
+            run.recordFile.clear();
+            for (size_t a = 0; a < options.axes.size(); a++) {
+                setTuning(run.tuning, *options.axes[a].field, points[n][a]);
+            }
+            Backtester backtester(symbols, run, tape.get());
+            results[n] = backtester.run();
+        }
+    };
+
+    int64_t startNanos = monotonicNanos();
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0);
+    for (std::thread& t : pool) t.join();
+    double seconds = (monotonicNanos() - startNanos) / 1e9;
+
+    std::vector<size_t> order(points.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const BacktestResult& x = results[a];
+        const BacktestResult& y = results[b];
+        if (options.rank == SweepRank::WinRate && winRate(x) != winRate(y)) return winRate(x) > winRate(y);
+        if (options.rank == SweepRank::Drawdown && x.maxDrawdown != y.maxDrawdown) return x.maxDrawdown < y.maxDrawdown;
+        return x.finalValue > y.finalValue;
+    });
+
+    std::cout << std::right << std::setw(5) << "Rank";
+    for (const SweepAxis& axis : options.axes) {
+        std::cout << std::setw(std::max<int>(12, static_cast<int>(std::strlen(axis.field->name)) + 2)) << axis.field->name;
+    }
+    std::cout << std::setw(14) << "P&L" << std::setw(9) << "Return" << std::setw(8) << "Win%"
+        << std::setw(8) << "MaxDD%" << std::setw(8) << "Trades" << "\n";
+    for (size_t r = 0; r < std::min(options.top, order.size()); r++) {
+        const BacktestResult& result = results[order[r]];
+        double pnl = result.finalValue - config.capital;
+        std::cout << std::setw(5) << r + 1 << std::setprecision(4);
+        for (size_t a = 0; a < options.axes.size(); a++) {
+            std::cout << std::setw(std::max<int>(12, static_cast<int>(std::strlen(options.axes[a].field->name)) + 2))
+                << points[order[r]][a];
+        }
+        std::cout << std::setprecision(2) << std::setw(14) << pnl
+            << std::setprecision(1) << std::setw(8) << pnl / config.capital * 100 << "%"
+            << std::setw(8) << winRate(result) * 100 << std::setw(8) << result.maxDrawdown * 100
+            << std::setw(8) << result.trades << "\n";
+    }
+
+    uint64_t ticks = 0;
+    for (const BacktestResult& result : results) ticks += result.ticks;
+    std::cout << Color::CYAN << "[SWEEP] " << points.size() << " backtests in " << std::setprecision(3) << seconds
+        << "s (" << std::setprecision(2) << points.size() / seconds << " backtests/sec, "
+        << std::setprecision(0) << ticks / seconds << " ticks/sec)\n" << Color::RESET;
+    std::cout << Color::CYAN << "[SWEEP] Best:";
+    for (size_t a = 0; a < options.axes.size(); a++) {
+        std::cout << " --tune=" << options.axes[a].field->name << "=" << std::setprecision(6)
+            << std::defaultfloat << points[order[0]][a];
+    }
+    std::cout << "\n" << Color::RESET << std::fixed;
+    return 0;
+}
+
+// Set from a signal handler; a lock-free atomic is safe to store there
+std::atomic<bool> shutdownRequested(false);
+
+extern "C" void onShutdownSignal(int sig) {
+    shutdownRequested.store(true);
+    std::signal(sig, SIG_DFL);  // a second signal still kills a stuck shutdown
+}
+
+void installShutdownHandlers() {
+    std::signal(SIGINT, onShutdownSignal);
+    std::signal(SIGTERM, onShutdownSignal);
+}
+
+// One flag per line, with or without the leading --: `capital=100000`,
+// `headless`, `tune=exit.stop_loss=0.02`. Blank lines and lines
+// starting with # are skipped.
+bool loadConfigFile(const std::string& path, std::vector<std::string>& args, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open file";
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        size_t last = line.find_last_not_of(" \t\r");
+        std::string item = line.substr(first, last - first + 1);
+        if (item.compare(0, 2, "--") == 0) item = item.substr(2);
+        size_t eq = item.find('=');
+        if (eq != std::string::npos) {
+            size_t keyEnd = item.find_last_not_of(" \t", eq == 0 ? 0 : eq - 1);
+            size_t valueStart = item.find_first_not_of(" \t", eq + 1);
+            item = item.substr(0, keyEnd == std::string::npos ? 0 : keyEnd + 1) + "="
+                + (valueStart == std::string::npos ? "" : item.substr(valueStart));
+        }
+        if (item.empty() || item[0] == '=') {
+            error = "line " + std::to_string(lineNumber) + ": expected NAME or NAME=VALUE";
+            return false;
+        }
+        if (item.compare(0, 7, "config=") == 0) {
+            error = "line " + std::to_string(lineNumber) + ": a config file cannot include another";
+            return false;
+        }
+        args.push_back("--" + item);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    SystemConfig config;
+    std::vector<size_t> scalingSizes;
+    SweepOptions sweep;
+    std::string publishUrl;
+    // A config file's lines take its place on the command line, so flags after it override it
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--config=") != 0) {
+            args.push_back(arg);
+            continue;
+        }
+        std::string configError;
+        if (!loadConfigFile(arg.substr(9), args, configError)) {
+            std::cout << Color::RED << "Cannot load config " << arg.substr(9) << ": " << configError
+                << "\n" << Color::RESET;
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        if (arg.compare(0, 10, "--journal=") == 0) {
+            config.journalFile = arg.substr(10);
+        }
+        if (arg.compare(0, 18, "--journal-records=") == 0) {
+            uint64_t records = 0;
+            if (!parseUnsigned(arg.substr(18), MAX_JOURNAL_RECORDS, records) || records < MIN_JOURNAL_RECORDS) {
+                std::cout << Color::RED << "Bad --journal-records '" << arg.substr(18) << "' (expected "
+                    << MIN_JOURNAL_RECORDS << " to " << MAX_JOURNAL_RECORDS << ")\n" << Color::RESET;
+                return 1;
+            }
+            config.journalRecords = static_cast<size_t>(records);
+        }
+        if (arg == "--headless") {
+            config.headless = true;
+        }
+        if (arg.compare(0, 13, "--warm-start=") == 0) {
+            config.warmStartFile = arg.substr(13);
+        }
+        if (arg.compare(0, 10, "--metrics=") == 0) {
+            config.metricsAddress = arg.substr(10);
+        }
+        if (arg.compare(0, 15, "--latency-dump=") == 0) {
+            uint64_t seconds = 0;
+            if (!parseUnsigned(arg.substr(15), MAX_LATENCY_DUMP_SECONDS, seconds)) {
+                std::cout << Color::RED << "Bad --latency-dump '" << arg.substr(15) << "' (expected 0 to "
+                    << MAX_LATENCY_DUMP_SECONDS << " seconds)\n" << Color::RESET;
+                return 1;
+            }
+            config.latencyDumpSeconds = static_cast<int>(seconds);
+        }
+        if (arg.compare(0, 12, "--log-level=") == 0) {
+            if (!parseLogLevel(arg.substr(12), config.logLevel)) {
+                std::cout << Color::RED << "Unknown log level '" << arg.substr(12)
+                    << "' (expected debug, info, warn or off)\n" << Color::RESET;
+                return 1;
+            }
+        }
+        if (arg.compare(0, 11, "--log-file=") == 0) {
+            config.logFile = arg.substr(11);
+        }
+        if (arg == "--backtest") {
+            config.backtestSteps = DEFAULT_BACKTEST_STEPS;
+        }
+        if (arg.compare(0, 11, "--backtest=") == 0) {
+            uint64_t steps = 0;
+            if (!parseUnsigned(arg.substr(11), std::numeric_limits<uint64_t>::max(), steps) || steps == 0) {
+                std::cout << Color::RED << "Bad --backtest '" << arg.substr(11)
+                    << "' (expected a positive number of steps)\n" << Color::RESET;
+                return 1;
+            }
+            config.backtestSteps = steps;
+        }
+        if (arg.compare(0, 7, "--seed=") == 0) {
+            uint64_t seed = 0;
+            if (!parseUnsigned(arg.substr(7), std::numeric_limits<uint32_t>::max(), seed)) {
+                std::cout << Color::RED << "Bad --seed '" << arg.substr(7) << "' (expected 0 to "
+                    << std::numeric_limits<uint32_t>::max() << ")\n" << Color::RESET;
+                return 1;
+            }
+            config.seed = static_cast<uint32_t>(seed);
+        }
+        if (arg.compare(0, 10, "--capital=") == 0) {
+            config.capital = std::atof(arg.substr(10).c_str());
+        }
+        if (arg.compare(0, 11, "--accounts=") == 0) {
+            uint64_t count = 0;
+            if (!parseUnsigned(arg.substr(11), MAX_ACCOUNTS, count) || count == 0) {
+                std::cout << Color::RED << "Bad --accounts '" << arg.substr(11) << "' (expected 1 to "
+                    << MAX_ACCOUNTS << ")\n" << Color::RESET;
+                return 1;
+            }
+            config.accountWeights.assign(static_cast<size_t>(count), 1.0);
+        }
+        if (arg.compare(0, 18, "--account-weights=") == 0) {
+            config.accountWeights.clear();
+            if (!parseWeightList(arg.substr(18), config.accountWeights)) {
+                std::cout << Color::RED << "Bad account weights '" << arg.substr(18)
+                    << "' (expected up to " << MAX_ACCOUNTS << " positive numbers, e.g. 2,1,1)\n" << Color::RESET;
+                return 1;
+            }
+        }
+        if (arg.compare(0, 9, "--shards=") == 0) {
+            config.shardCount = static_cast<size_t>(std::max(1, std::atoi(arg.substr(9).c_str())));
+        }
+        if (arg.compare(0, 9, "--record=") == 0) {
+            config.recordFile = arg.substr(9);
+        }
+        if (arg.compare(0, 9, "--replay=") == 0) {
+            config.replayFile = arg.substr(9);
+        }
+        if (arg.compare(0, 7, "--feed=") == 0) {
+            config.feedUrl = arg.substr(7);
+        }
+        if (arg == "--book") {
+            config.orderBooks = true;
+        }
+        if (arg.compare(0, 7, "--book=") == 0) {
+            uint64_t levels = 0;
+            if (!parseUnsigned(arg.substr(7), BOOK_SNAPSHOT_LEVELS, levels) || levels == 0) {
+                std::cout << Color::RED << "Bad --book '" << arg.substr(7) << "' (expected 1 to "
+                    << BOOK_SNAPSHOT_LEVELS << " synthetic levels)\n" << Color::RESET;
+                return 1;
+            }
+            config.orderBooks = true;
+            config.bookLevels = static_cast<size_t>(levels);
+        }
+        if (arg.compare(0, 10, "--gateway=") == 0) {
+            if (!parseGatewayModel(arg.substr(10), config.gateway.model)) {
+                std::cout << Color::RED << "Unknown gateway '" << arg.substr(10)
+                    << "' (expected simple or match)\n" << Color::RESET;
+                return 1;
+            }
+        }
+        if (arg.compare(0, 20, "--gateway-jitter-us=") == 0) {
+            config.gateway.jitterNanos = static_cast<int64_t>(std::atof(arg.substr(20).c_str()) * 1000.0);
+        }
+        if (arg.compare(0, 18, "--gateway-rest-ms=") == 0) {
+            config.gateway.restTimeoutNanos = static_cast<int64_t>(std::atof(arg.substr(18).c_str()) * 1e6);
+        }
+        if (arg.compare(0, 19, "--gateway-turnover=") == 0) {
+            config.gateway.touchTurnover = std::min(1.0, std::max(0.0, std::atof(arg.substr(19).c_str())));
+        }
+        if (arg == "--passive-entries") {
+            config.tuning.trade.passiveEntries = true;
+        }
+        if (arg.compare(0, 21, "--gateway-latency-us=") == 0) {
+            config.gateway.latencyNanos = static_cast<int64_t>(std::atof(arg.substr(21).c_str()) * 1000.0);
+        }
+        if (arg.compare(0, 17, "--gateway-slices=") == 0) {
+            config.gateway.slices = std::max(1, std::atoi(arg.substr(17).c_str()));
+        }
+        if (arg.compare(0, 21, "--gateway-collar-bps=") == 0) {
+            config.gateway.collarBps = std::atof(arg.substr(21).c_str());
+        }
+        if (arg.compare(0, 15, "--feed-publish=") == 0) {
+            publishUrl = arg.substr(15);
+        }
+        if (arg.compare(0, 15, "--replay-speed=") == 0) {
+            config.replaySpeed = std::max(0.0, std::atof(arg.substr(15).c_str()));
+        }
+        if (arg.compare(0, 16, "--max-positions=") == 0) {
+            config.risk.maxOpenPositions = std::max(0, std::atoi(arg.substr(16).c_str()));
+        }
+        if (arg.compare(0, 15, "--max-notional=") == 0) {
+            config.risk.maxOrderNotional = std::max(0.0, std::atof(arg.substr(15).c_str()));
+        }
+        if (arg.compare(0, 17, "--max-order-rate=") == 0) {
+            config.risk.maxOrdersPerSecond = std::max(0, std::atoi(arg.substr(17).c_str()));
+        }
+        if (arg.compare(0, 15, "--max-drawdown=") == 0) {
+            config.risk.maxDrawdown = std::max(0.0, std::atof(arg.substr(15).c_str())) / 100.0;
+        }
+        if (arg == "--batch-signals") {
+            config.batchSignals = true;
+        }
+        if (arg == "--virtual-strategies") {
+            config.virtualStrategies = true;
+        }
+        if (arg.compare(0, 12, "--generator=") == 0) {
+            if (!parseFeedGenerator(arg.substr(12), config.generator)) {
+                std::cout << Color::RED << "Unknown generator '" << arg.substr(12)
+                    << "' (expected classic or fast)\n" << Color::RESET;
+                return 1;
+            }
+        }
+        if (arg.compare(0, 19, "--tick-interval-us=") == 0) {
+            config.tickIntervalNanos = std::max<int64_t>(0, std::atoll(arg.c_str() + 19)) * 1000;
+        }
+        if (arg.compare(0, 11, "--universe=") == 0) {
+            config.universeFile = arg.substr(11);
+        }
+        if (arg.compare(0, 10, "--symbols=") == 0) {
+            uint64_t size = 0;
+            if (!parseUnsigned(arg.substr(10), MAX_UNIVERSE_SIZE, size) || size == 0) {
+                std::cout << Color::RED << "Bad --symbols '" << arg.substr(10) << "' (expected 1 to "
+                    << MAX_UNIVERSE_SIZE << ")\n" << Color::RESET;
+                return 1;
+            }
+            config.universeSize = static_cast<size_t>(size);
+        }
+        if (arg == "--scaling-bench") {
+            scalingSizes = DEFAULT_SCALING_SIZES;
+        }
+        if (arg.compare(0, 16, "--scaling-bench=") == 0) {
+            scalingSizes.clear();
+            if (!parseSizeList(arg.substr(16), scalingSizes)) {
+                std::cout << Color::RED << "Bad universe sizes '" << arg.substr(16)
+                    << "' (expected e.g. 100,1000,10000)\n" << Color::RESET;
+                return 1;
+            }
+        }
+        if (arg.compare(0, 11, "--pin-feed=") == 0) {
+            config.placement.feedCpu = std::atoi(arg.c_str() + 11);
+        }
+        if (arg.compare(0, 14, "--pin-trading=") == 0) {
+            config.placement.tradingCpus.clear();
+            if (!parseCpuList(arg.substr(14), config.placement.tradingCpus)) {
+                std::cout << Color::RED << "Bad CPU list '" << arg.substr(14)
+                    << "' (expected e.g. 2,3,4)\n" << Color::RESET;
+                return 1;
+            }
+        }
+        if (arg.compare(0, 19, "--pin-housekeeping=") == 0) {
+            config.placement.housekeepingCpu = std::atoi(arg.c_str() + 19);
+        }
+        if (arg == "--pin=auto") {
+            config.placement.autoAssign = true;
+        }
+        if (arg == "--realtime") {
+            config.placement.realtime = true;
+        }
+        if (arg == "--numa-local") {
+            config.placement.numaLocal = true;
+        }
+        if (arg.compare(0, 7, "--tune=") == 0) {
+            std::string spec = arg.substr(7);
+            size_t eq = spec.find('=');
+            const TuningField* field = findTuningField(spec.substr(0, eq));
+            char* end = nullptr;
+            double value = eq == std::string::npos ? 0.0 : std::strtod(spec.c_str() + eq + 1, &end);
+            if (field == nullptr || end == nullptr || *end != '\0' || end == spec.c_str() + eq + 1) {
+                std::cout << Color::RED << "Bad tuning '" << spec << "' (expected NAME=VALUE; names: "
+                    << tuningFieldNames() << ")\n" << Color::RESET;
+                return 1;
+            }
+            setTuning(config.tuning, *field, value);
+        }
+        if (arg.compare(0, 13, "--sweep-axis=") == 0) {
+            SweepAxis axis;
+            std::string error;
+            if (!parseSweepAxis(arg.substr(13), axis, error)) {
+                std::cout << Color::RED << "Bad sweep axis: " << error << "\n" << Color::RESET;
+                return 1;
+            }
+            sweep.axes.push_back(axis);
+        }
+        if (arg.compare(0, 15, "--sweep-random=") == 0) {
+            sweep.randomPoints = static_cast<size_t>(std::strtoull(arg.c_str() + 15, nullptr, 10));
+        }
+        if (arg.compare(0, 16, "--sweep-threads=") == 0) {
+            sweep.threads = std::max<size_t>(1, static_cast<size_t>(std::strtoull(arg.c_str() + 16, nullptr, 10)));
+        }
+        if (arg.compare(0, 12, "--sweep-top=") == 0) {
+            sweep.top = static_cast<size_t>(std::strtoull(arg.c_str() + 12, nullptr, 10));
+        }
+        if (arg.compare(0, 13, "--sweep-rank=") == 0) {
+            if (!parseSweepRank(arg.substr(13), sweep.rank)) {
+                std::cout << Color::RED << "Unknown sweep ranking '" << arg.substr(13)
+                    << "' (expected pnl, winrate or drawdown)\n" << Color::RESET;
+                return 1;
+            }
+        }
+        if (arg == "--no-simd") {
+            config.allowSimd = false;
+        }
+        if (arg.compare(0, 7, "--wait=") == 0) {
+            if (!parseWaitPolicy(arg.substr(7), config.waitPolicy)) {
+                std::cout << Color::RED << "Unknown wait policy '" << arg.substr(7)
+                    << "' (expected spin, hybrid or block)\n" << Color::RESET;
+                return 1;
+            }
+        }
+    }
+    if (config.tuning.trade.passiveEntries && config.gateway.model != GatewayModel::Matching) {
+        // The simple gateway fills every order at its price, so a bid would always be hit
+        std::cout << Color::RED << "--passive-entries needs --gateway=match\n" << Color::RESET;
+        return 1;
+    }
+    if (config.accountWeights.size() > 1 && !config.journalFile.empty()) {
+        // Journal records carry one account's cash; a journal per account is still to come
+        std::cout << Color::RED << "--journal keeps a single account; drop --accounts\n" << Color::RESET;
+        return 1;
+    }
+
+    std::cout << Color::BOLD << Color::CYAN;
+    std::cout << "\n============================================================\n";
+    std::cout << "          HIGH-FREQUENCY TRADING SYSTEM v3.0                \n";
+    std::cout << "============================================================\n";
+    std::cout << Color::RESET << "\n";
+
+    if (config.placement.autoAssign && !resolveAutoPlacement(config.placement, config.shardCount)) {
+        std::cout << Color::YELLOW << "[INIT] --pin=auto needs " << config.shardCount + 3
+            << " cores; threads stay unpinned\n" << Color::RESET;
+    }
+
+    if (!scalingSizes.empty()) {
+        if (config.capital == 0) config.capital = DEFAULT_BACKTEST_CAPITAL;
+        return runScalingBench(config, scalingSizes);
+    }
+
+    std::vector<std::string> universe;
+    std::string universeError;
+    if (!loadUniverse(config, universe, universeError)) {
+        std::cout << Color::RED << "Cannot load universe"
+            << (config.universeFile.empty() ? "" : " " + config.universeFile) << ": "
+            << universeError << "\n" << Color::RESET;
+        return 1;
+    }
+    SymbolTable symbols(universe);
+    if (config.accountWeights.size() > symbols.size()) {
+        std::cout << Color::RED << config.accountWeights.size() << " accounts for " << symbols.size()
+            << " symbols would leave an account with nothing to trade\n" << Color::RESET;
+        return 1;
+    }
+
+    std::unique_ptr<TickFile> replay;
+    if (!config.replayFile.empty()) {
+        replay = std::make_unique<TickFile>(config.replayFile);
+        if (!replay->isOpen()) {
+            std::cout << Color::RED << "Cannot replay " << config.replayFile << ": "
+                << replay->getError() << "\n" << Color::RESET;
+            return 1;
+        }
+    }
+
+    if (!publishUrl.empty()) return runFeedPublisher(symbols, config, publishUrl);
+
+    if (!sweep.axes.empty()) {
+        if (config.backtestSteps == 0) config.backtestSteps = DEFAULT_BACKTEST_STEPS;
+        if (config.capital == 0) config.capital = DEFAULT_BACKTEST_CAPITAL;
+        return runSweep(symbols, config, replay.get(), sweep);
+    }
+
+    if (config.backtestSteps > 0) {
+        if (config.capital == 0) config.capital = DEFAULT_BACKTEST_CAPITAL;
+        if (config.capital < 1000) {
+            std::cout << Color::RED << "Minimum capital is $1,000\n" << Color::RESET;
+            return 1;
+        }
+        return runBacktest(symbols, config, replay.get());
+    }
+
+    std::unique_ptr<FeedHandler> feed;
+    if (!config.feedUrl.empty()) {
+        std::string feedError;
+        feed = openFeedHandler(config.feedUrl, symbols, feedError);
+        if (!feed) {
+            std::cout << Color::RED << "Cannot open feed " << config.feedUrl << ": " << feedError
+                << "\n" << Color::RESET;
+            return 1;
+        }
+    }
+
+    std::unique_ptr<WriteAheadJournal> journal;
+    if (!config.journalFile.empty()) {
+        journal = std::make_unique<WriteAheadJournal>();
+        std::string journalError;
+        if (!journal->open(config.journalFile, symbols, config.journalRecords, journalError)) {
+            std::cout << Color::RED << "Cannot open journal " << config.journalFile << ": " << journalError
+                << "\n" << Color::RESET;
+            return 1;
+        }
+        // A journal that has traded before supplies the capital; its cash comes back on recovery
+        if (journal->hasState()) config.capital = journal->getInitialCapital();
+    }
+
+    double& capital = config.capital;
+    if (capital == 0 && config.headless) {
+        std::cout << Color::RED << "--headless needs --capital (or a journal that has traded)\n" << Color::RESET;
+        return 1;
+    }
+    if (capital == 0) {
+        std::cout << Color::YELLOW << "Enter starting capital (e.g., 100000): $" << Color::RESET;
+        std::cin >> capital;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+
+    if (capital < 1000) {
+        std::cout << Color::RED << "Minimum capital is $1,000\n" << Color::RESET;
+        return 1;
+    }
+
+    // Built on the first trading CPU so the per-symbol state it allocates
+    // lands on that CPU's NUMA node
+    std::unique_ptr<ScopedCpuAffinity> firstTouch;
+    int homeCpu = config.placement.tradingCpu(0);
+    if (config.placement.numaLocal && homeCpu >= 0) {
+        firstTouch = std::make_unique<ScopedCpuAffinity>(homeCpu);
+        if (firstTouch->isPinned()) {
+            int node = cpuNumaNode(homeCpu);
+            std::cout << Color::CYAN << "[INIT] NUMA: trading state first-touched from cpu " << homeCpu;
+            if (node >= 0) std::cout << " (node " << node << ")";
+            std::cout << "\n" << Color::RESET;
+        }
+    }
+    HFTSystem system(symbols, config, replay.get(), feed.get(), journal.get());
+    firstTouch.reset();
+    if (!config.warmStartFile.empty()) {
+        // Unmapped before start() opens a recording, which may be this same file
+        TickFile warm(config.warmStartFile);
+        if (!warm.isOpen()) {
+            std::cout << Color::RED << "Cannot warm start from " << config.warmStartFile << ": "
+                << warm.getError() << "\n" << Color::RESET;
+            return 1;
+        }
+        system.warmStart(warm, config.warmStartFile);
+    }
+    std::string journalError;
+    if (!system.recoverJournal(journalError)) {
+        std::cout << Color::RED << "Cannot recover from " << config.journalFile << ": " << journalError
+            << "\n" << Color::RESET;
+        return 1;
+    }
+    if (config.headless) installShutdownHandlers();
+    system.start();
+
+    if (config.headless) {
+        while (!shutdownRequested.load()) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    else {
+        std::cin.get();
+    }
 
     system.stop();
 
     return 0;
-}
\ No newline at end of file
+}
+#endif